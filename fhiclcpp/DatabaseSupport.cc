@@ -30,18 +30,17 @@ fhicl::decompose_parameterset(fhicl::ParameterSet const& top,
   // vectors thereof.
   std::vector<std::string> keys = top.get_names();
   for (auto const& key : keys) {
-    if (top.is_key_to_table(key))
+    auto const kind = top.kind_of(key);
+    if (kind == value_kind::table)
       decompose_parameterset(top.get<ParameterSet>(key), records, hashes);
-    else if (top.is_key_to_sequence(key)) {
-      try {
-        auto nestlings = top.get<std::vector<ParameterSet>>(key);
-        for (auto const& ps : nestlings)
+    else if (kind == value_kind::sequence) {
+      // A sequence that does not hold only ParameterSets needs no
+      // further action.
+      auto const nestlings = top.try_get<std::vector<ParameterSet>>(key);
+      if (nestlings) {
+        for (auto const& ps : *nestlings)
           decompose_parameterset(ps, records, hashes);
       }
-      catch (fhicl::exception const&) {
-        // The vector didn't contain ParameterSets, keep going; no
-        // corrective action is needed.
-      }
     }
   }
 }
@@ -0,0 +1,77 @@
+// ======================================================================
+//
+// Key
+//
+// ======================================================================
+
+#include "fhiclcpp/Key.h"
+#include "fhiclcpp/exception.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+using fhicl::Key;
+
+namespace {
+
+  [[noreturn]] void
+  throw_malformed(std::string_view const key)
+  {
+    throw fhicl::exception(fhicl::cant_find, std::string{key})
+      << "Malformed sequence index.";
+  }
+
+  // Appends to indices the indices in "[0][5][1]", starting at pos.
+  void
+  read_indices(std::string_view const key,
+               std::size_t pos,
+               std::size_t const end,
+               std::vector<std::size_t>& indices)
+  {
+    constexpr auto max = std::numeric_limits<std::size_t>::max();
+    while (pos != end) {
+      if (key[pos] != '[' || ++pos == end || key[pos] == ']') {
+        throw_malformed(key);
+      }
+      std::size_t index{};
+      for (; pos != end && key[pos] != ']'; ++pos) {
+        auto const c = key[pos];
+        if (c < '0' || c > '9' || index > (max - (c - '0')) / 10) {
+          throw_malformed(key);
+        }
+        index = index * 10 + (c - '0');
+      }
+      if (pos == end) {
+        throw_malformed(key);
+      }
+      indices.push_back(index);
+      ++pos;
+    }
+  }
+}
+
+Key::Key(std::string_view const key) : text_{key}
+{
+  std::vector<Step> steps;
+  for (std::size_t begin{}; begin <= key.size();) {
+    auto end = key.find('.', begin);
+    if (end == std::string_view::npos) {
+      end = key.size();
+    }
+    // Empty names, as in "a..b", are skipped.
+    if (end != begin) {
+      auto const bracket = std::min(key.find('[', begin), end);
+      auto& step = steps.emplace_back();
+      step.name = key.substr(begin, bracket - begin);
+      read_indices(key, bracket, end, step.indices);
+    }
+    begin = end + 1;
+  }
+  if (steps.empty()) {
+    throw fhicl::exception(fhicl::cant_find, "vacuous key");
+  }
+  last_ = std::move(steps.back());
+  steps.pop_back();
+  tables_ = std::move(steps);
+}
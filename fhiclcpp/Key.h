@@ -0,0 +1,58 @@
+#ifndef fhiclcpp_Key_h
+#define fhiclcpp_Key_h
+
+// ======================================================================
+//
+// Key
+//
+// A ParameterSet key -- "a.b[2][0].c" -- split once into the names
+// and sequence indices that lead to its value.  Every ParameterSet
+// retriever that takes a std::string key also takes a Key; code that
+// looks up the same key repeatedly can construct it once and so avoid
+// splitting the string on each call.
+//
+// A key with no names in it (e.g. "" or ".") is rejected on
+// construction, as is a malformed sequence index.
+//
+// ======================================================================
+
+#include "fhiclcpp/fwd.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ----------------------------------------------------------------------
+
+class fhicl::Key {
+public:
+  explicit Key(std::string_view key);
+
+  std::string const&
+  to_string() const noexcept
+  {
+    return text_;
+  }
+
+private:
+  friend class ParameterSet;
+
+  // One name, with the indices (if any) that follow it.
+  struct Step {
+    std::string name;
+    std::vector<std::size_t> indices;
+  };
+
+  // The tables to descend through, and the key within the last of
+  // them.
+  std::vector<Step> tables_;
+  Step last_;
+  std::string text_;
+};
+
+#endif /* fhiclcpp_Key_h */
+
+// Local Variables:
+// mode: c++
+// End:
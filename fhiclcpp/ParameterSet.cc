@@ -12,10 +12,13 @@
 #include "fhiclcpp/detail/Prettifier.h"
 #include "fhiclcpp/detail/PrettifierAnnotated.h"
 #include "fhiclcpp/detail/PrettifierPrefixAnnotated.h"
+#include "fhiclcpp/detail/Sink.h"
+#include "fhiclcpp/detail/TypedAtom.h"
 #include "fhiclcpp/extended_value.h"
 #include "fhiclcpp/intermediate_table.h"
 #include "fhiclcpp/parse.h"
 
+#include <atomic>
 #include <cstddef>
 #include <stack>
 
@@ -54,12 +57,40 @@ namespace {
     }
   }
 
-  ParameterSet const&
+  void
+  write_id_reference(Sink& sink, ParameterSetID const& psid)
+  {
+    char buf[5 + ParameterSetID::max_str_size()]{'@', 'i', 'd', ':', ':'};
+    psid.to_chars(buf + 5);
+    sink << std::string_view{buf, sizeof buf};
+  }
+
+  ParameterSet
   get_pset_via_any(std::any const& a)
   {
     ParameterSetID const& psid = std::any_cast<ParameterSetID>(a);
     return ParameterSetRegistry::get(psid);
   }
+
+  // A value as walkers are given it (see ParameterSetWalker.h),
+  // whatever the form in which it is stored.
+  std::any
+  walker_value(std::any const& a)
+  {
+    if (auto const* atom = std::any_cast<TypedAtom>(&a)) {
+      return atom->text();
+    }
+    if (is_sequence(a)) {
+      auto const elements = sequence_elements(a);
+      ps_sequence_t result;
+      result.reserve(elements.size());
+      for (auto const& element : elements) {
+        result.push_back(walker_value(element));
+      }
+      return result;
+    }
+    return a;
+  }
 }
 
 // ----------------------------------------------------------------------
@@ -113,32 +144,65 @@ fhicl::ParameterSet::make(std::string const& filename,
 
 // ======================================================================
 
-string
-ParameterSet::stringify_(any const& a, bool const compact) const
+void
+ParameterSet::stringify_(Sink& sink, any const& a, table_form const tf) const
 {
-  string result;
   if (is_table(a)) {
     auto const& psid = any_cast<ParameterSetID>(a);
-    result = '{' + ParameterSetRegistry::get(psid).to_string() + '}';
-    if (compact && result.size() > (5 + ParameterSetID::max_str_size())) {
-      // Replace with a reference to the ParameterSetID;
-      result = std::string("@id::") + psid.to_string();
+    if (tf == table_form::id) {
+      // The nested table's ID covers its contents.  The ID it is held
+      // under may have been computed by another scheme (e.g. read from
+      // an existing DB), so its ID under this one is written instead.
+      ParameterSet table;
+      write_id_reference(
+        sink, ParameterSetRegistry::get(psid, table) ? table.id() : psid);
+    } else if (tf == table_form::compact) {
+      // The table is copied out of the registry, which stringifying it
+      // may insert into.
+      ParameterSet const table{ParameterSetRegistry::get(psid)};
+      string nested;
+      StringSink nested_sink{nested};
+      table.to_string_(nested_sink, table_form::expanded);
+      if (nested.size() + 2 > (5 + ParameterSetID::max_str_size())) {
+        // Replace with a reference to the ParameterSetID;
+        write_id_reference(sink, psid);
+      } else {
+        sink << '{' << nested << '}';
+      }
+    } else {
+      ParameterSet const table{ParameterSetRegistry::get(psid)};
+      sink << '{';
+      table.to_string_(sink, tf);
+      sink << '}';
     }
+  } else if (auto const* packed = any_cast<detail::PackedSequence>(&a)) {
+    sink << '[';
+    for (std::size_t i = 0, n = packed->size(); i != n; ++i) {
+      if (i != 0) {
+        sink << ',';
+      }
+      sink << packed->text(i);
+    }
+    sink << ']';
   } else if (is_sequence(a)) {
     auto const& seq = any_cast<ps_sequence_t>(a);
-    result = '[';
+    sink << '[';
     if (!seq.empty()) {
-      result.append(stringify_(*seq.begin(), compact));
+      stringify_(sink, *seq.begin(), tf);
       for (auto it = seq.cbegin(), e = seq.cend(); ++it != e;) {
-        result.append(1, ',').append(stringify_(*it, compact));
+        sink << ',';
+        stringify_(sink, *it, tf);
       }
     }
-    result.append(1, ']');
+    sink << ']';
   } else { // is_atom(a)
-    ps_atom_t const str = any_cast<ps_atom_t>(a);
-    result = str == string(9, '\0') ? "@nil" : str;
+    auto const& str = *detail::atom_text(a);
+    if (str.size() == 9 && str.find_first_not_of('\0') == string::npos) {
+      sink << "@nil";
+    } else {
+      sink << str;
+    }
   }
-  return result;
 } // stringify_()
 
 // ----------------------------------------------------------------------
@@ -146,42 +210,65 @@ ParameterSet::stringify_(any const& a, bool const compact) const
 bool
 ParameterSet::is_empty() const
 {
-  return mapping_.empty();
+  return read_().mapping.empty();
 }
 
 ParameterSetID
 ParameterSet::id() const
 {
-  if (!id_.is_valid()) {
-    id_.reset(*this);
+  return read_().id.get([this] { return ParameterSetID{*this}; });
+}
+
+auto
+ParameterSet::write_() -> Contents&
+{
+  if (!contents_) {
+    contents_ = std::make_shared<Contents>();
+  } else if (contents_.use_count() != 1) {
+    // Other copies may be reading these contents.
+    contents_ = std::make_shared<Contents>(*contents_);
+  } else {
+    // use_count() is a relaxed load: without this fence, the reads of
+    // a copy just released on another thread could still be in flight
+    // as these contents are written.
+    std::atomic_thread_fence(std::memory_order_acquire);
   }
-  return id_;
+  contents_->id.invalidate();
+  return *contents_;
 }
 
 string
-ParameterSet::to_string_(bool const compact) const
+ParameterSet::to_string_(table_form const tf) const
 {
   string result;
-  if (mapping_.empty()) {
-    return result;
+  StringSink sink{result};
+  to_string_(sink, tf);
+  return result;
+}
+
+void
+ParameterSet::to_string_(Sink& sink, table_form const tf) const
+{
+  auto const& mapping = read_().mapping;
+  if (mapping.empty()) {
+    return;
   }
-  auto it = mapping_.begin();
-  result.append(it->first).append(1, ':').append(
-    stringify_(it->second, compact));
-  for (auto const e = mapping_.end(); ++it != e;) {
-    result.append(1, ' ').append(it->first).append(1, ':').append(
-      stringify_(it->second, compact));
+  auto it = mapping.begin();
+  sink << it->first << ':';
+  stringify_(sink, it->second, tf);
+  for (auto const e = mapping.end(); ++it != e;) {
+    sink << ' ' << it->first << ':';
+    stringify_(sink, it->second, tf);
   }
-  return result;
 }
 
 vector<string>
 ParameterSet::get_names() const
 {
   vector<string> keys;
-  cet::transform_all(mapping_, std::back_inserter(keys), [](auto const& pr) {
-    return pr.first;
-  });
+  cet::transform_all(read_().mapping,
+                     std::back_inserter(keys),
+                     [](auto const& pr) { return pr.first; });
   return keys;
 }
 
@@ -189,7 +276,7 @@ vector<string>
 ParameterSet::get_pset_names() const
 {
   vector<string> keys;
-  for (auto const& [key, value] : mapping_) {
+  for (auto const& [key, value] : read_().mapping) {
     if (is_table(value)) {
       keys.push_back(key);
     }
@@ -205,71 +292,83 @@ ParameterSet::get_all_keys() const
   return ka.result();
 }
 
-bool
-ParameterSet::find_one_(std::string const& simple_key) const
+std::any const*
+ParameterSet::find_value_(std::string_view const name,
+                          std::vector<std::size_t> const& indices,
+                          std::any& element) const
 {
-  auto skey = detail::get_sequence_indices(simple_key);
-
-  auto it = mapping_.find(skey.name());
-  if (it == mapping_.end()) {
-    return false;
+  auto const& mapping = read_().mapping;
+  auto it = mapping.find(name);
+  if (it == mapping.end()) {
+    return nullptr;
   }
+  return detail::any_at(indices.cbegin(), indices.cend(), it->second, element);
+}
 
-  auto a = it->second;
-  return detail::find_an_any(skey.indices().cbegin(), skey.indices().cend(), a);
+std::any const*
+ParameterSet::find_(std::string_view const key,
+                    std::any& element,
+                    ParameterSet& table) const
+{
+  if (detail::is_local_key(key)) {
+    return find_value_(key, {}, element);
+  }
+  return find_(Key{key}, element, table);
 }
 
-std::optional<ParameterSet>
-ParameterSet::descend_(std::vector<std::string> const& names) const
+std::any const*
+ParameterSet::find_(Key const& key,
+                    std::any& element,
+                    ParameterSet& table) const
 {
-  if (empty(names)) {
-    return std::make_optional(*this);
+  if (key.tables_.empty()) {
+    return find_value_(key.last_.name, key.last_.indices, element);
   }
-  ParameterSet const* p{this};
-  std::optional<ParameterSet> result;
-  for (auto const& name : names) {
-    if (!p->find_one_(name)) {
-      return std::nullopt;
-    }
-    if (!p->is_key_to_table(name)) {
-      return std::nullopt;
-    }
+  auto ps = descend_(key);
+  if (!ps) {
+    return nullptr;
+  }
+  table = *std::move(ps);
+  return table.find_value_(key.last_.name, key.last_.indices, element);
+}
 
-    if (result = p->get_one_<ParameterSet>(name); not result) {
+std::optional<ParameterSet>
+ParameterSet::descend_(Key const& key) const
+{
+  // Copying a table shares its contents, so holding one costs no more
+  // than a reference count.
+  std::optional<ParameterSet> result{*this};
+  for (auto const& step : key.tables_) {
+    std::any element;
+    auto const* a = result->find_value_(step.name, step.indices, element);
+    if (a == nullptr || !is_table(*a)) {
       return std::nullopt;
     }
-    p = &result.value();
+    result = ParameterSetRegistry::get(std::any_cast<ParameterSetID>(*a));
   }
   return result;
 }
 
-bool
-ParameterSet::has_key(std::string const& key) const
-{
-  auto keys = detail::get_names(key);
-  auto ps = descend_(keys.tables());
-  return ps ? ps->find_one_(keys.last()) : false;
-}
-
 // ----------------------------------------------------------------------
 
 std::string
-ParameterSet::get_src_info(std::string const& key) const
+ParameterSet::get_src_info(std::string_view const key) const
 {
-  auto result = srcMapping_.find(key);
-  return result != srcMapping_.cend() ? result->second : "";
+  auto const& srcMapping = read_().srcMapping;
+  auto result = srcMapping.find(key);
+  return result != srcMapping.cend() ? result->second : "";
 }
 
 // ----------------------------------------------------------------------
 
 void
-ParameterSet::put(std::string const& key)
+ParameterSet::put(std::string_view const key)
 {
   put(key, nullptr);
 }
 
 void
-ParameterSet::put_or_replace(std::string const& key)
+ParameterSet::put_or_replace(std::string_view const key)
 {
   put_or_replace(key, nullptr); // Replace with nil is always OK.
 }
@@ -278,38 +377,38 @@ ParameterSet::put_or_replace(std::string const& key)
 
 namespace {
   inline void
-  check_put_local_key(std::string const& key)
+  check_put_local_key(std::string_view const key)
   {
-    if (key.find('.') != std::string::npos) {
+    if (key.find('.') != std::string_view::npos) {
       throw fhicl::exception(unimplemented, "putXXX() for nested key.");
     }
   }
 }
 
 void
-ParameterSet::insert_(string const& key, any const& value)
+ParameterSet::insert_(std::string_view const key, any const& value)
 {
   check_put_local_key(key);
-  if (!mapping_.emplace(key, value).second) {
+  if (!write_().mapping.emplace(string{key}, detail::typed(value)).second) {
     throw exception(cant_insert) << "key " << key << " already exists.";
   }
-  id_.invalidate();
 }
 
 void
-ParameterSet::insert_or_replace_(string const& key, any const& value)
+ParameterSet::insert_or_replace_(std::string_view const key, any const& value)
 {
   check_put_local_key(key);
-  mapping_[key] = value;
-  id_.invalidate();
+  write_().mapping[string{key}] = detail::typed(value);
 }
 
 void
-ParameterSet::insert_or_replace_compatible_(string const& key, any const& value)
+ParameterSet::insert_or_replace_compatible_(std::string_view const key,
+                                            any const& value)
 {
   check_put_local_key(key);
-  auto item = mapping_.find(key);
-  if (item == mapping_.end()) {
+  auto const& mapping = read_().mapping;
+  auto item = mapping.find(key);
+  if (item == mapping.end()) {
     insert_(key, value);
     return;
   } else {
@@ -329,48 +428,127 @@ ParameterSet::insert_or_replace_compatible_(string const& key, any const& value)
           << "can't use non-atom to replace non-nil atom.";
       }
     }
-    item->second = value;
+    write_().mapping[string{key}] = detail::typed(value);
   }
-  id_.invalidate();
 }
 
 bool
-ParameterSet::erase(string const& key)
+ParameterSet::erase(std::string_view const key)
 {
-  bool const did_erase{1u == mapping_.erase(key)};
-  id_.invalidate();
-  return did_erase;
+  // Erasing nothing does not unshare the contents.
+  if (read_().mapping.find(key) == read_().mapping.end()) {
+    return false;
+  }
+  return 1u == write_().mapping.erase(key);
 }
 
-bool
-ParameterSet::key_is_type_(std::string const& key,
-                           std::function<bool(std::any const&)> func) const
+void
+ParameterSet::erase_src_info_(std::string_view const key)
 {
-  auto split_keys = detail::get_names(key);
-  auto ps = descend_(split_keys.tables());
-  if (not ps) {
-    throw exception(error::cant_find, key);
+  auto const& srcMapping = read_().srcMapping;
+  if (srcMapping.find(key) == srcMapping.cend()) {
+    return;
+  }
+  auto& annotations = write_().srcMapping;
+  annotations.erase(annotations.find(key));
+}
+
+namespace {
+  // Allowance for the heap block std::any allocates for each value
+  // (none fits in its internal buffer), allocator bookkeeping included.
+  constexpr std::size_t any_overhead{4 * sizeof(void*)};
+  // Per-node overhead of the std::map holding the annotations.
+  constexpr std::size_t annotation_overhead{4 * sizeof(void*)};
+
+  std::size_t
+  string_footprint(std::string const& s)
+  {
+    // Short strings are stored in place.
+    return sizeof(std::string) + (s.capacity() > 15 ? s.capacity() + 1 : 0);
   }
 
-  auto skey = detail::get_sequence_indices(split_keys.last());
+  std::size_t
+  any_footprint(std::any const& a)
+  {
+    std::size_t result{sizeof(std::any) + any_overhead};
+    if (is_table(a)) {
+      result += sizeof(ParameterSetID);
+    } else if (auto const* packed = std::any_cast<detail::PackedSequence>(&a)) {
+      result += packed->footprint();
+    } else if (is_sequence(a)) {
+      auto const& seq = *std::any_cast<ps_sequence_t>(&a);
+      result += sizeof(ps_sequence_t) +
+                (seq.capacity() - seq.size()) * sizeof(std::any);
+      for (auto const& element : seq) {
+        result += any_footprint(element);
+      }
+    } else if (auto const* atom = std::any_cast<detail::TypedAtom>(&a)) {
+      result += sizeof(detail::TypedAtom) - sizeof(std::string) +
+                string_footprint(atom->text());
+    }
+    return result;
+  }
+}
 
-  auto it = ps->mapping_.find(skey.name());
-  if (it == ps->mapping_.end()) {
-    throw exception(error::cant_find, key);
+std::size_t
+ParameterSet::footprint_() const
+{
+  // Contents shared with other copies are counted in full.
+  std::size_t result{sizeof(ParameterSet) + sizeof(Contents)};
+  auto const& contents = read_();
+  // The FlatMap stores its elements contiguously, with no per-element
+  // overhead beyond that of the key and the value.
+  for (auto const& [key, value] : contents.mapping) {
+    result += string_footprint(key) + any_footprint(value);
+  }
+  for (auto const& [key, info] : contents.srcMapping) {
+    result +=
+      annotation_overhead + string_footprint(key) + string_footprint(info);
   }
+  return result;
+}
 
-  auto a = it->second;
-  return detail::find_an_any(
-           skey.indices().cbegin(), skey.indices().cend(), a) ?
-           func(a) :
-           throw exception(error::cant_find, key);
+value_kind
+ParameterSet::kind_of(std::string_view const key) const
+{
+  std::any element;
+  ParameterSet table;
+  auto const* a = find_(key, element, table);
+  return a != nullptr ? detail::kind_of(*a) : value_kind::absent;
+}
+
+value_kind
+ParameterSet::kind_of(Key const& key) const
+{
+  std::any element;
+  ParameterSet table;
+  auto const* a = find_(key, element, table);
+  return a != nullptr ? detail::kind_of(*a) : value_kind::absent;
+}
+
+value_kind
+ParameterSet::existing_kind_(std::string_view const key) const
+{
+  auto const result = kind_of(key);
+  return result != value_kind::absent ?
+           result :
+           throw exception(error::cant_find, std::string{key});
+}
+
+value_kind
+ParameterSet::existing_kind_(Key const& key) const
+{
+  auto const result = kind_of(key);
+  return result != value_kind::absent ?
+           result :
+           throw exception(error::cant_find, key.to_string());
 }
 
 // ======================================================================
 // 'put' specialization for extended_value
 //
 // With this specialization, the free function 'fill_src_info' is
-// called, which fills an std::unordered_map whose key-value pairs
+// called, which fills a std::map whose key-value pairs
 // correspond to the ParameterSet key and the location
 // (filename:line#) where the key was last overridden.
 //
@@ -379,14 +557,14 @@ ParameterSet::key_is_type_(std::string const& key,
 // possible because each entry from a 'sequence_t' in the intermediate
 // table is an extended_value that has a data member 'src_info'.  Note
 // that whenever a printout is provided, the extended_value instances
-// are no longer used, but only the mapping_ key-value pairs, which
+// are no longer used, but only the mapping key-value pairs, which
 // are the ParameterSet names and associated std::any objects.
 //
 // ParameterSet instances therefore do not have a natural way of
 // storing source information for sequence entries because the
 // extended-value information is lost.  In other words,  simply doing
 //
-//      srcMapping_[key] = value.src_info;
+//      srcMapping[key] = value.src_info;
 //
 // whenever 'put' is called will insert the source information for the
 // sequence, but not for each sequence entry.  To get around this, the
@@ -406,12 +584,13 @@ ParameterSet::key_is_type_(std::string const& key,
 namespace fhicl {
   template <>
   void
-  ParameterSet::put(std::string const& key, fhicl::extended_value const& value)
+  ParameterSet::put(std::string_view const key,
+                    fhicl::extended_value const& value)
   {
     auto insert = [this, &value](auto const& key) {
       using detail::encode;
       this->insert_(key, std::any(encode(value)));
-      fill_src_info(value, key, srcMapping_);
+      fill_src_info(value, std::string{key}, write_().srcMapping);
     };
     detail::try_insert(insert, key);
   }
@@ -432,18 +611,20 @@ ParameterSet::walk(ParameterSetWalker& psw) const
       psw.do_before_action(key, a, ps);
 
       if (is_table(a)) {
-        ParameterSet const* ps = &get_pset_via_any(a);
-        ps_stack.push(ps);
+        // The walker may insert into the registry, so the table is
+        // held by copy for as long as it is walked.
+        ParameterSet const table{get_pset_via_any(a)};
+        ps_stack.push(&table);
         psw.do_enter_table(key, a);
-        for (auto const& [nested_key, nested_a] : ps->mapping_) {
-          act_on_element(nested_key, nested_a);
+        for (auto const& [nested_key, nested_a] : table.read_().mapping) {
+          act_on_element(nested_key, walker_value(nested_a));
         }
         psw.do_exit_table(key, a);
         ps_stack.pop();
       } else if (is_sequence(a)) {
         psw.do_enter_sequence(key, a);
         std::size_t i{};
-        for (auto const& elem : any_cast<ps_sequence_t>(a)) {
+        for (auto const& elem : std::any_cast<ps_sequence_t const&>(a)) {
           std::string const new_key = key + "["s + std::to_string(i++) + "]";
           act_on_element(new_key, elem);
         }
@@ -455,8 +636,8 @@ ParameterSet::walk(ParameterSetWalker& psw) const
       psw.do_after_action(key);
     };
 
-  for (auto const& [key, value] : mapping_) {
-    act_on_element(key, value);
+  for (auto const& [key, value] : read_().mapping) {
+    act_on_element(key, walker_value(value));
   }
 }
 
@@ -519,8 +700,10 @@ ParameterSet::to_indented_string(unsigned const initial_indent_level,
   template _DECODE_##FHICL_TYPE##_(T);                                         \
   template _GET_ONE_(T);                                                       \
   template _GET(T);                                                            \
+  template _GET_KEY(T);                                                        \
   template _GET_WITH_DEFAULT(T);                                               \
-  template _GET_IF_PRESENT(T)
+  template _GET_IF_PRESENT(T);                                                 \
+  template _GET_IF_PRESENT_KEY(T)
 
 _INSTANTIATE_GET(ATOM, bool);
 _INSTANTIATE_GET(ATOM, int);
@@ -8,23 +8,31 @@
 // ======================================================================
 
 #include "cetlib_except/demangle.h"
+#include "fhiclcpp/Key.h"
 #include "fhiclcpp/ParameterSetID.h"
 #include "fhiclcpp/coding.h"
+#include "fhiclcpp/detail/CachedID.h"
+#include "fhiclcpp/detail/FlatMap.h"
 #include "fhiclcpp/detail/ParameterSetImplHelpers.h"
 #include "fhiclcpp/detail/encode_extended_value.h"
 #include "fhiclcpp/detail/print_mode.h"
 #include "fhiclcpp/detail/try_blocks.h"
 #include "fhiclcpp/exception.h"
 #include "fhiclcpp/fwd.h"
+#include "fhiclcpp/get_result.h"
+#include "fhiclcpp/sequence_view.h"
+#include "fhiclcpp/value_kind.h"
 
 #include <any>
 #include <functional>
 #include <map>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <typeinfo>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 // ----------------------------------------------------------------------
@@ -33,13 +41,20 @@ namespace cetlib {
   class filepath_maker;
 }
 
+namespace fhicl::detail {
+  class Sink;
+}
+
 class fhicl::ParameterSet {
 public:
   using ps_atom_t = fhicl::detail::ps_atom_t;
   using ps_sequence_t = fhicl::detail::ps_sequence_t;
-  using annot_t = std::unordered_map<std::string, std::string>;
+  using annot_t = std::map<std::string, std::string, std::less<>>;
 
   // compiler generates default c'tor, d'tor, copy c'tor, copy assignment
+  //
+  // Copies share their contents, which are copied only when a copy
+  // that shares them is modified, so copying is cheap.
 
   static ParameterSet make(intermediate_table const& tbl);
   static ParameterSet make(extended_value const& xval);
@@ -65,85 +80,174 @@ public:
   std::vector<std::string> get_pset_names() const;
   std::vector<std::string> get_all_keys() const;
 
-  // retrievers (nested key OK):
-  bool has_key(std::string const& key) const;
-  bool is_key_to_table(std::string const& key) const;
-  bool is_key_to_sequence(std::string const& key) const;
-  bool is_key_to_atom(std::string const& key) const;
+  // retrievers (nested key OK; a Key may be given for any key):
+  bool has_key(std::string_view key) const;
+  bool has_key(Key const& key) const;
+  bool is_key_to_table(std::string_view key) const;
+  bool is_key_to_table(Key const& key) const;
+  bool is_key_to_sequence(std::string_view key) const;
+  bool is_key_to_sequence(Key const& key) const;
+  bool is_key_to_atom(std::string_view key) const;
+  bool is_key_to_atom(Key const& key) const;
+  // What key names -- value_kind::absent if nothing, where the
+  // is_key_to_ functions throw.
+  value_kind kind_of(std::string_view key) const;
+  value_kind kind_of(Key const& key) const;
 
   template <class T>
-  std::optional<T> get_if_present(std::string const& key) const;
+  std::optional<T> get_if_present(std::string_view key) const;
+  template <class T>
+  std::optional<T> get_if_present(Key const& key) const;
   template <class T, class Via>
-  std::optional<T> get_if_present(std::string const& key,
+  std::optional<T> get_if_present(std::string_view key,
                                   T convert(Via const&)) const;
+  template <class T, class Via>
+  std::optional<T> get_if_present(Key const& key, T convert(Via const&)) const;
 
   // Obsolete interface
   template <class T>
-  bool get_if_present(std::string const& key, T& value) const;
+  bool get_if_present(std::string_view key, T& value) const;
+  template <class T>
+  bool get_if_present(Key const& key, T& value) const;
   template <class T, class Via>
-  bool get_if_present(std::string const& key,
+  bool get_if_present(std::string_view key,
                       T& value,
                       T convert(Via const&)) const;
+  template <class T, class Via>
+  bool get_if_present(Key const& key, T& value, T convert(Via const&)) const;
 
   template <class T>
-  T get(std::string const& key) const;
+  T get(std::string_view key) const;
+  template <class T>
+  T get(Key const& key) const;
   template <class T, class Via>
-  T get(std::string const& key, T convert(Via const&)) const;
+  T get(std::string_view key, T convert(Via const&)) const;
+  template <class T, class Via>
+  T get(Key const& key, T convert(Via const&)) const;
+  template <class T>
+  T get(std::string_view key, T const& default_value) const;
   template <class T>
-  T get(std::string const& key, T const& default_value) const;
+  T get(Key const& key, T const& default_value) const;
   template <class T, class Via>
-  T get(std::string const& key,
+  T get(std::string_view key,
         T const& default_value,
         T convert(Via const&)) const;
+  template <class T, class Via>
+  T get(Key const& key, T const& default_value, T convert(Via const&)) const;
 
-  std::string get_src_info(std::string const& key) const;
+  // As get_if_present, except that a value that cannot be converted to
+  // a T is reported in the result instead of by an exception.
+  template <class T>
+  get_result<T> try_get(std::string_view key) const;
+  template <class T>
+  get_result<T> try_get(Key const& key) const;
+
+  // A view of the values of a sequence of numbers that is stored
+  // packed, as Ts (double, or std::intmax_t for integers); empty if
+  // there is no such key or its value is not stored so, in which case
+  // get<std::vector<T>> still applies.
+  template <class T>
+  std::optional<sequence_view<T>> get_view(std::string_view key) const;
+  template <class T>
+  std::optional<sequence_view<T>> get_view(Key const& key) const;
+
+  std::string get_src_info(std::string_view key) const;
 
   // Facility to traverse the ParameterSet tree
   void walk(ParameterSetWalker& psw) const;
 
   // inserters (key must be local: no nesting):
-  void put(std::string const& key); // Implicit nil value.
+  void put(std::string_view key); // Implicit nil value.
   template <class T>                // Fail on preexisting key.
-  void put(std::string const& key, T const& value);
-  void put_or_replace(std::string const& key); // Implicit nil value.
+  void put(std::string_view key, T const& value);
+  void put_or_replace(std::string_view key); // Implicit nil value.
   template <class T>                           // Succeed.
-  void put_or_replace(std::string const& key, T const& value);
+  void put_or_replace(std::string_view key, T const& value);
   template <class T> // Fail if preexisting key of incompatible type.
-  void put_or_replace_compatible(std::string const& key, T const& value);
+  void put_or_replace_compatible(std::string_view key, T const& value);
 
   // deleters:
-  bool erase(std::string const& key);
+  bool erase(std::string_view key);
 
   // comparators:
   bool operator==(ParameterSet const& other) const;
   bool operator!=(ParameterSet const& other) const;
 
 private:
-  using map_t = std::map<std::string, std::any>;
+  friend class ParameterSetID;
+  friend class ParameterSetRegistry;
+
+  // Keys are few, short and canonically ordered, and tables are read
+  // far more often than they are modified.
+  using map_t = detail::FlatMap<std::string, std::any>;
   using map_iter_t = map_t::const_iterator;
 
-  map_t mapping_;
-  annot_t srcMapping_;
-  mutable ParameterSetID id_;
+  struct Contents {
+    map_t mapping;
+    annot_t srcMapping;
+    detail::CachedID id;
+  };
+
+  // Shared by copies, and never modified while shared; null when
+  // empty (or moved from).
+  std::shared_ptr<Contents> contents_{};
+
+  // The contents to read, and the contents to modify, which are first
+  // made this ParameterSet's own if they are shared.
+  Contents const& read_() const noexcept;
+  Contents& write_();
 
   // Private inserters.
-  void insert_(std::string const& key, std::any const& value);
-  void insert_or_replace_(std::string const& key, std::any const& value);
-  void insert_or_replace_compatible_(std::string const& key,
+  void insert_(std::string_view key, std::any const& value);
+  void insert_or_replace_(std::string_view key, std::any const& value);
+  void insert_or_replace_compatible_(std::string_view key,
                                      std::any const& value);
+  void erase_src_info_(std::string_view key);
+
+  // Rendering of nested tables: expanded in full, replaced by an
+  // '@id::' reference when that is shorter, or always by reference.
+  enum class table_form { expanded, compact, id };
 
-  std::string to_string_(bool compact = false) const;
-  std::string stringify_(std::any const& a, bool compact = false) const;
+  std::string to_string_(table_form tf = table_form::expanded) const;
+  void to_string_(detail::Sink& sink, table_form tf) const;
+  void stringify_(detail::Sink& sink,
+                  std::any const& a,
+                  table_form tf) const;
 
-  bool key_is_type_(std::string const& key,
-                    std::function<bool(std::any const&)> func) const;
+  // What key names; throws if it is absent.
+  value_kind existing_kind_(std::string_view key) const;
+  value_kind existing_kind_(Key const& key) const;
 
-  // Local retrieval only.
+  // Estimated heap and object size, excluding nested tables (which
+  // are stored separately, by ID).
+  std::size_t footprint_() const;
+
+  // Local retrieval only, of the element of name at indices.
+  template <class T>
+  std::optional<T> get_one_(std::string_view name,
+                            std::vector<std::size_t> const& indices) const;
   template <class T>
-  std::optional<T> get_one_(std::string const& key) const;
-  bool find_one_(std::string const& key) const;
-  std::optional<ParameterSet> descend_(
-    std::vector<std::string> const& names) const;
+  get_result<T> try_get_one_(std::string_view name,
+                             std::vector<std::size_t> const& indices) const;
+  // The element of name at indices, or nullptr; see detail::any_at
+  // for element.
+  std::any const* find_value_(std::string_view name,
+                              std::vector<std::size_t> const& indices,
+                              std::any& element) const;
+  // The value key names, or nullptr.  A local key is looked up as it
+  // is, without making a Key of it.  A value in a nested table is
+  // found in a copy of that table, made in table, which must outlive
+  // the use of the result.
+  std::any const* find_(std::string_view key,
+                        std::any& element,
+                        ParameterSet& table) const;
+  std::any const* find_(Key const& key,
+                        std::any& element,
+                        ParameterSet& table) const;
+  // A copy of the table reached through the tables of key (or of this
+  // table, if there are none), if any.  Copies share their contents,
+  // and remain valid should the registry evict its entry.
+  std::optional<ParameterSet> descend_(Key const& key) const;
 
 }; // ParameterSet
 
@@ -156,23 +260,32 @@ private:
   void fhicl::detail::decode<T::value_type>(std::any const&, T&)
 
 #define _GET_ONE_(T)                                                           \
-  std::optional<T> fhicl::ParameterSet::get_one_<T>(std::string const&) const
+  std::optional<T> fhicl::ParameterSet::get_one_<T>(                           \
+    std::string_view, std::vector<std::size_t> const&) const
 
-#define _GET(T) T fhicl::ParameterSet::get<T>(std::string const&) const
+#define _GET(T) T fhicl::ParameterSet::get<T>(std::string_view) const
+
+#define _GET_KEY(T) T fhicl::ParameterSet::get<T>(fhicl::Key const&) const
 
 #define _GET_WITH_DEFAULT(T)                                                   \
-  T fhicl::ParameterSet::get<T>(std::string const&, T const&) const
+  T fhicl::ParameterSet::get<T>(std::string_view, T const&) const
 
 #define _GET_IF_PRESENT(T)                                                     \
-  std::optional<T> fhicl::ParameterSet::get_if_present<T>(std::string const&)  \
+  std::optional<T> fhicl::ParameterSet::get_if_present<T>(std::string_view)    \
+    const
+
+#define _GET_IF_PRESENT_KEY(T)                                                 \
+  std::optional<T> fhicl::ParameterSet::get_if_present<T>(fhicl::Key const&)   \
     const
 
 #define _EXTERN_INSTANTIATE_GET(FHICL_TYPE, T)                                 \
   extern template _DECODE_##FHICL_TYPE##_(T);                                  \
   extern template _GET_ONE_(T);                                                \
   extern template _GET(T);                                                     \
+  extern template _GET_KEY(T);                                                 \
   extern template _GET_WITH_DEFAULT(T);                                        \
-  extern template _GET_IF_PRESENT(T)
+  extern template _GET_IF_PRESENT(T);                                          \
+  extern template _GET_IF_PRESENT_KEY(T)
 
 _EXTERN_INSTANTIATE_GET(ATOM, bool);
 _EXTERN_INSTANTIATE_GET(ATOM, int);
@@ -201,32 +314,66 @@ fhicl::ParameterSet::to_string() const
 inline std::string
 fhicl::ParameterSet::to_compact_string() const
 {
-  return to_string_(true);
+  return to_string_(table_form::compact);
+}
+
+inline bool
+fhicl::ParameterSet::has_key(std::string_view key) const
+{
+  std::any element;
+  ParameterSet table;
+  return find_(key, element, table) != nullptr;
+}
+
+inline bool
+fhicl::ParameterSet::has_key(Key const& key) const
+{
+  std::any element;
+  ParameterSet table;
+  return find_(key, element, table) != nullptr;
+}
+
+inline bool
+fhicl::ParameterSet::is_key_to_table(std::string_view key) const
+{
+  return existing_kind_(key) == value_kind::table;
+}
+
+inline bool
+fhicl::ParameterSet::is_key_to_table(Key const& key) const
+{
+  return existing_kind_(key) == value_kind::table;
+}
+
+inline bool
+fhicl::ParameterSet::is_key_to_sequence(std::string_view key) const
+{
+  return existing_kind_(key) == value_kind::sequence;
 }
 
 inline bool
-fhicl::ParameterSet::is_key_to_table(std::string const& key) const
+fhicl::ParameterSet::is_key_to_sequence(Key const& key) const
 {
-  return key_is_type_(key, &detail::is_table);
+  return existing_kind_(key) == value_kind::sequence;
 }
 
 inline bool
-fhicl::ParameterSet::is_key_to_sequence(std::string const& key) const
+fhicl::ParameterSet::is_key_to_atom(std::string_view key) const
 {
-  return key_is_type_(key, &detail::is_sequence);
+  auto const kind = existing_kind_(key);
+  return kind == value_kind::atom || kind == value_kind::nil;
 }
 
 inline bool
-fhicl::ParameterSet::is_key_to_atom(std::string const& key) const
+fhicl::ParameterSet::is_key_to_atom(Key const& key) const
 {
-  return key_is_type_(key, [](std::any const& a) {
-    return !(detail::is_sequence(a) || detail::is_table(a));
-  });
+  auto const kind = existing_kind_(key);
+  return kind == value_kind::atom || kind == value_kind::nil;
 }
 
 template <class T>
 void
-fhicl::ParameterSet::put(std::string const& key, T const& value)
+fhicl::ParameterSet::put(std::string_view key, T const& value)
 {
   auto insert = [this, &value](auto const& key) {
     using detail::encode;
@@ -237,25 +384,25 @@ fhicl::ParameterSet::put(std::string const& key, T const& value)
 
 template <class T>
 void
-fhicl::ParameterSet::put_or_replace(std::string const& key, T const& value)
+fhicl::ParameterSet::put_or_replace(std::string_view key, T const& value)
 {
   auto insert_or_replace = [this, &value](auto const& key) {
     using detail::encode;
     this->insert_or_replace_(key, std::any(encode(value)));
-    srcMapping_.erase(key);
+    this->erase_src_info_(key);
   };
   detail::try_insert(insert_or_replace, key);
 }
 
 template <class T>
 void
-fhicl::ParameterSet::put_or_replace_compatible(std::string const& key,
+fhicl::ParameterSet::put_or_replace_compatible(std::string_view key,
                                                T const& value)
 {
   auto insert_or_replace_compatible = [this, &value](auto const& key) {
     using detail::encode;
     this->insert_or_replace_compatible_(key, std::any(encode(value)));
-    srcMapping_.erase(key);
+    this->erase_src_info_(key);
   };
   detail::try_insert(insert_or_replace_compatible, key);
 }
@@ -264,18 +411,81 @@ fhicl::ParameterSet::put_or_replace_compatible(std::string const& key,
 
 template <class T>
 std::optional<T>
-fhicl::ParameterSet::get_if_present(std::string const& key) const
+fhicl::ParameterSet::get_if_present(std::string_view key) const
 {
-  auto keys = detail::get_names(key);
-  if (auto ps = descend_(keys.tables())) {
-    return ps->get_one_<T>(keys.last());
+  if (detail::is_local_key(key)) {
+    return get_one_<T>(key, {});
+  }
+  return get_if_present<T>(Key{key});
+}
+
+template <class T>
+std::optional<T>
+fhicl::ParameterSet::get_if_present(Key const& key) const
+{
+  if (auto ps = descend_(key)) {
+    return ps->get_one_<T>(key.last_.name, key.last_.indices);
   }
   return std::nullopt;
 }
 
+template <class T>
+fhicl::get_result<T>
+fhicl::ParameterSet::try_get(std::string_view key) const
+{
+  if (detail::is_local_key(key)) {
+    return try_get_one_<T>(key, {});
+  }
+  return try_get<T>(Key{key});
+}
+
+template <class T>
+fhicl::get_result<T>
+fhicl::ParameterSet::try_get(Key const& key) const
+{
+  if (auto ps = descend_(key)) {
+    return ps->try_get_one_<T>(key.last_.name, key.last_.indices);
+  }
+  return {};
+}
+
+template <class T>
+std::optional<fhicl::sequence_view<T>>
+fhicl::ParameterSet::get_view(std::string_view key) const
+{
+  std::any element;
+  ParameterSet table;
+  auto const* a = find_(key, element, table);
+  auto const* packed = std::any_cast<detail::PackedSequence>(a);
+  return packed ? packed->view<T>() : std::nullopt;
+}
+
+template <class T>
+std::optional<fhicl::sequence_view<T>>
+fhicl::ParameterSet::get_view(Key const& key) const
+{
+  std::any element;
+  ParameterSet table;
+  auto const* a = find_(key, element, table);
+  auto const* packed = std::any_cast<detail::PackedSequence>(a);
+  return packed ? packed->view<T>() : std::nullopt;
+}
+
+template <class T, class Via>
+std::optional<T>
+fhicl::ParameterSet::get_if_present(std::string_view key,
+                                    T convert(Via const&)) const
+{
+  auto go_between = get_if_present<Via>(key);
+  if (not go_between) {
+    return std::nullopt;
+  }
+  return std::make_optional(convert(*go_between));
+}
+
 template <class T, class Via>
 std::optional<T>
-fhicl::ParameterSet::get_if_present(std::string const& key,
+fhicl::ParameterSet::get_if_present(Key const& key,
                                     T convert(Via const&)) const
 {
   auto go_between = get_if_present<Via>(key);
@@ -287,7 +497,18 @@ fhicl::ParameterSet::get_if_present(std::string const& key,
 
 template <class T>
 bool
-fhicl::ParameterSet::get_if_present(std::string const& key, T& value) const
+fhicl::ParameterSet::get_if_present(std::string_view key, T& value) const
+{
+  if (auto present_parameter = get_if_present<T>(key)) {
+    value = *present_parameter;
+    return true;
+  }
+  return false;
+}
+
+template <class T>
+bool
+fhicl::ParameterSet::get_if_present(Key const& key, T& value) const
 {
   if (auto present_parameter = get_if_present<T>(key)) {
     value = *present_parameter;
@@ -298,7 +519,20 @@ fhicl::ParameterSet::get_if_present(std::string const& key, T& value) const
 
 template <class T, class Via>
 bool
-fhicl::ParameterSet::get_if_present(std::string const& key,
+fhicl::ParameterSet::get_if_present(std::string_view key,
+                                    T& result,
+                                    T convert(Via const&)) const
+{
+  if (auto present_parameter = get_if_present<T>(key, convert)) {
+    result = *present_parameter;
+    return true;
+  }
+  return false;
+}
+
+template <class T, class Via>
+bool
+fhicl::ParameterSet::get_if_present(Key const& key,
                                     T& result,
                                     T convert(Via const&)) const
 {
@@ -311,23 +545,47 @@ fhicl::ParameterSet::get_if_present(std::string const& key,
 
 template <class T>
 T
-fhicl::ParameterSet::get(std::string const& key) const
+fhicl::ParameterSet::get(std::string_view key) const
+{
+  auto result = get_if_present<T>(key);
+  return result ? *result : throw fhicl::exception(cant_find, std::string{key});
+}
+
+template <class T>
+T
+fhicl::ParameterSet::get(Key const& key) const
 {
   auto result = get_if_present<T>(key);
-  return result ? *result : throw fhicl::exception(cant_find, key);
+  return result ? *result : throw fhicl::exception(cant_find, key.to_string());
 }
 
 template <class T, class Via>
 T
-fhicl::ParameterSet::get(std::string const& key, T convert(Via const&)) const
+fhicl::ParameterSet::get(std::string_view key, T convert(Via const&)) const
 {
   auto result = get_if_present<T>(key, convert);
-  return result ? *result : throw fhicl::exception(cant_find, key);
+  return result ? *result : throw fhicl::exception(cant_find, std::string{key});
+}
+
+template <class T, class Via>
+T
+fhicl::ParameterSet::get(Key const& key, T convert(Via const&)) const
+{
+  auto result = get_if_present<T>(key, convert);
+  return result ? *result : throw fhicl::exception(cant_find, key.to_string());
+}
+
+template <class T>
+T
+fhicl::ParameterSet::get(std::string_view key, T const& default_value) const
+{
+  auto result = get_if_present<T>(key);
+  return result ? *result : default_value;
 }
 
 template <class T>
 T
-fhicl::ParameterSet::get(std::string const& key, T const& default_value) const
+fhicl::ParameterSet::get(Key const& key, T const& default_value) const
 {
   auto result = get_if_present<T>(key);
   return result ? *result : default_value;
@@ -335,7 +593,17 @@ fhicl::ParameterSet::get(std::string const& key, T const& default_value) const
 
 template <class T, class Via>
 T
-fhicl::ParameterSet::get(std::string const& key,
+fhicl::ParameterSet::get(std::string_view key,
+                         T const& default_value,
+                         T convert(Via const&)) const
+{
+  auto result = get_if_present<T>(key, convert);
+  return result ? *result : default_value;
+}
+
+template <class T, class Via>
+T
+fhicl::ParameterSet::get(Key const& key,
                          T const& default_value,
                          T convert(Via const&)) const
 {
@@ -348,7 +616,7 @@ fhicl::ParameterSet::get(std::string const& key,
 inline bool
 fhicl::ParameterSet::operator==(ParameterSet const& other) const
 {
-  return id() == other.id();
+  return contents_ == other.contents_ || id() == other.id();
 }
 
 inline bool
@@ -359,53 +627,82 @@ fhicl::ParameterSet::operator!=(ParameterSet const& other) const
 
 // ----------------------------------------------------------------------
 
+inline auto
+fhicl::ParameterSet::read_() const noexcept -> Contents const&
+{
+  static Contents const empty{};
+  return contents_ ? *contents_ : empty;
+}
+
+// ----------------------------------------------------------------------
+
 template <class T>
 std::optional<T>
-fhicl::ParameterSet::get_one_(std::string const& key) const
+fhicl::ParameterSet::get_one_(std::string_view const name,
+                              std::vector<std::size_t> const& indices) const
 {
   T value;
   try {
-    auto skey = detail::get_sequence_indices(key);
-
-    map_iter_t it = mapping_.find(skey.name());
-    if (it == mapping_.end()) {
+    auto const& mapping = read_().mapping;
+    map_iter_t it = mapping.find(name);
+    if (it == mapping.end()) {
       return std::nullopt;
     }
 
-    auto a = it->second;
-    if (!detail::find_an_any(
-          skey.indices().cbegin(), skey.indices().cend(), a)) {
+    std::any element;
+    auto const* a =
+      detail::any_at(indices.cbegin(), indices.cend(), it->second, element);
+    if (a == nullptr) {
       throw fhicl::exception(error::cant_find);
     }
 
     using detail::decode;
-    decode(a, value);
-    return std::make_optional(value);
+    decode(*a, value);
+    return std::make_optional(std::move(value));
   }
   catch (fhicl::exception const& e) {
     std::ostringstream errmsg;
-    errmsg << "\nUnsuccessful attempt to convert FHiCL parameter '" << key
-           << "' to type '" << cet::demangle_symbol(typeid(value).name())
-           << "'.\n\n"
+    errmsg << "\nUnsuccessful attempt to convert FHiCL parameter '"
+           << detail::indexed_key(name, indices) << "' to type '"
+           << cet::demangle_symbol(typeid(value).name()) << "'.\n\n"
            << "[Specific error:]";
     throw fhicl::exception(type_mismatch, errmsg.str(), e);
   }
   catch (std::exception const& e) {
     std::ostringstream errmsg;
-    errmsg << "\nUnsuccessful attempt to convert FHiCL parameter '" << key
-           << "' to type '" << cet::demangle_symbol(typeid(value).name())
-           << "'.\n\n"
+    errmsg << "\nUnsuccessful attempt to convert FHiCL parameter '"
+           << detail::indexed_key(name, indices) << "' to type '"
+           << cet::demangle_symbol(typeid(value).name()) << "'.\n\n"
            << "[Specific error:]\n"
            << e.what() << "\n\n";
     throw fhicl::exception(type_mismatch, errmsg.str());
   }
 }
 
+template <class T>
+fhicl::get_result<T>
+fhicl::ParameterSet::try_get_one_(
+  std::string_view const name,
+  std::vector<std::size_t> const& indices) const
+{
+  std::any element;
+  auto const* a = find_value_(name, indices, element);
+  if (a == nullptr) {
+    return {};
+  }
+  auto const kind = detail::kind_of(*a);
+  T value;
+  if (detail::try_decode(*a, value)) {
+    return {kind, std::move(value)};
+  }
+  return get_result<T>{kind};
+}
+
 // ----------------------------------------------------------------------
 
 namespace fhicl {
   template <>
-  void ParameterSet::put(std::string const& key,
+  void ParameterSet::put(std::string_view key,
                          fhicl::extended_value const& value);
 }
 
@@ -6,8 +6,9 @@
 
 #include "fhiclcpp/ParameterSetID.h"
 #include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/detail/Sink.h"
 
-#include <iomanip>
+#include <atomic>
 
 using namespace boost;
 using namespace cet;
@@ -18,6 +19,40 @@ using namespace std;
 
 constexpr sha1::digest_t invalid_id{{}};
 
+namespace {
+  // The scheme, and whether an ID has been computed under it, are kept
+  // in one word so that they change together.
+  constexpr unsigned scheme_in_use{0x100};
+  std::atomic<unsigned> scheme_state{
+    static_cast<unsigned>(id_scheme::canonical_string)};
+
+  constexpr id_scheme
+  scheme_of(unsigned const state) noexcept
+  {
+    return static_cast<id_scheme>(state & ~scheme_in_use);
+  }
+
+  // Prepended to the hashed form under the merkle scheme.  Because no
+  // ParameterSet key can begin with '@', no merkle-scheme input can
+  // coincide with a canonical_string-scheme input.
+  std::string const merkle_v1_tag{"@merkle:v1 "};
+
+  constexpr char hex_digits[]{"0123456789abcdef"};
+
+  // Value of a lowercase hex digit, or -1.
+  constexpr int
+  hex_value(char const c) noexcept
+  {
+    if (c >= '0' && c <= '9') {
+      return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+    }
+    return -1;
+  }
+}
+
 // ----------------------------------------------------------------------
 
 ParameterSetID::ParameterSetID() noexcept : valid_{false}, id_{invalid_id} {}
@@ -32,12 +67,14 @@ ParameterSetID::ParameterSetID(std::string const& id)
 {
   if (valid_) {
     for (size_t i = 0, e = id_.size(); i != e; ++i) {
-      id_[i] = std::stoi(id.substr(i * 2, 2), nullptr, 16);
-    }
-    if (id != to_string()) {
-      throw exception{error::cant_happen}
-        << "ParameterSetID construction failure: " << id
-        << " != " << to_string() << ".\n";
+      int const hi = hex_value(id[2 * i]);
+      int const lo = hex_value(id[2 * i + 1]);
+      if (hi < 0 || lo < 0) {
+        throw fhicl::exception{error::parse_error}
+          << "Attempt to construct ParameterSetID from inappropriate input: "
+          << id << ".\n";
+      }
+      id_[i] = static_cast<sha1::uchar>(hi << 4 | lo);
     }
   } else if (id.empty()) {
     id_ = invalid_id;
@@ -59,14 +96,42 @@ ParameterSetID::is_valid() const noexcept
 string
 ParameterSetID::to_string() const
 {
-  std::ostringstream oss;
-  oss << std::hex << std::setfill('0');
-  // The range-for loop performs an implicit cast from 'unsigned char'
-  // to 'unsigned int'.
-  for (unsigned int const num : id_) {
-    oss << std::setw(2) << num;
+  string result(max_str_size(), '0');
+  to_chars(result.data());
+  return result;
+}
+
+char*
+ParameterSetID::to_chars(char* first) const noexcept
+{
+  for (unsigned char const byte : id_) {
+    *first++ = hex_digits[byte >> 4];
+    *first++ = hex_digits[byte & 0xf];
   }
-  return oss.str();
+  return first;
+}
+
+id_scheme
+ParameterSetID::scheme() noexcept
+{
+  return scheme_of(scheme_state.load());
+}
+
+void
+ParameterSetID::set_scheme(id_scheme const scheme)
+{
+  auto state = scheme_state.load();
+  do {
+    if ((state & scheme_in_use) != 0) {
+      if (scheme_of(state) != scheme) {
+        throw exception{error::other}
+          << "The ParameterSetID scheme cannot be changed once IDs have "
+             "been computed.\n";
+      }
+      return;
+    }
+  } while (
+    !scheme_state.compare_exchange_weak(state, static_cast<unsigned>(scheme)));
 }
 
 // ----------------------------------------------------------------------
@@ -81,10 +146,22 @@ ParameterSetID::invalidate() noexcept
 void
 ParameterSetID::reset(ParameterSet const& ps)
 {
-  auto const& hash = ps.to_string();
-  sha1 sha{hash.c_str()};
+  // The first ID computed fixes the scheme, which is read in the same
+  // step.
+  auto state = scheme_state.load();
+  while ((state & scheme_in_use) == 0 &&
+         !scheme_state.compare_exchange_weak(state, state | scheme_in_use)) {
+  }
+  // The string form is streamed into the digest rather than built.
+  detail::SHA1Sink sink;
+  if (scheme_of(state) == id_scheme::merkle) {
+    sink << merkle_v1_tag;
+    ps.to_string_(sink, ParameterSet::table_form::id);
+  } else {
+    ps.to_string_(sink, ParameterSet::table_form::expanded);
+  }
 
-  id_ = sha.digest();
+  id_ = sink.digest();
   valid_ = true;
 }
 
@@ -138,7 +215,9 @@ ParameterSetID::operator>=(ParameterSetID const& other) const noexcept
 ostream&
 fhicl::operator<<(ostream& os, ParameterSetID const& psid)
 {
-  return os << psid.to_string();
+  char buf[ParameterSetID::max_str_size()];
+  psid.to_chars(buf);
+  return os.write(buf, sizeof buf);
 }
 
 // ======================================================================
@@ -5,6 +5,27 @@
 //
 // ParameterSetID
 //
+// The digest of a ParameterSet is computed according to the
+// process-wide id_scheme:
+//
+//   canonical_string: SHA-1 of ParameterSet::to_string(), in which
+//                     every nested table is expanded in full.  This is
+//                     the historical scheme, and the default.
+//
+//   merkle:           SHA-1 of a version tag followed by a form of the
+//                     ParameterSet in which each nested table is
+//                     represented by its own merkle ID (cached with
+//                     the table), whatever the ID it was registered
+//                     under.  Computing an ID therefore costs time
+//                     proportional only to the size of the table
+//                     itself, plus a registry lookup per nested table.
+//
+// The two schemes produce different IDs for the same content.  The
+// scheme must be chosen before the first ID is computed; IDs read
+// from existing databases (see ParameterSetRegistry::importFrom) are
+// looked up by value and therefore remain resolvable regardless of
+// the scheme in use.
+//
 // ======================================================================
 
 #include "cetlib/sha1.h"
@@ -15,6 +36,12 @@
 #include <string>
 
 namespace fhicl {
+  enum class id_scheme { canonical_string, merkle };
+
+  namespace detail {
+    class HashParameterSetID;
+  }
+
   std::ostream& operator<<(std::ostream&, ParameterSetID const&);
 }
 
@@ -30,8 +57,13 @@ public:
   // observers:
   bool is_valid() const noexcept;
   std::string to_string() const;
+  char* to_chars(char* first) const noexcept; // writes max_str_size() chars
   static constexpr std::size_t max_str_size() noexcept;
 
+  // process-wide digest scheme:
+  static id_scheme scheme() noexcept;
+  static void set_scheme(id_scheme);
+
   // mutators:
   void invalidate() noexcept;
   void reset(ParameterSet const&);
@@ -46,6 +78,8 @@ public:
   bool operator>=(ParameterSetID const&) const noexcept;
 
 private:
+  friend class detail::HashParameterSetID;
+
   bool valid_;
   cet::sha1::digest_t id_;
 
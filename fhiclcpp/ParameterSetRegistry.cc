@@ -11,20 +11,69 @@
 #include "fhiclcpp/exception.h"
 
 #include "sqlite3.h"
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstring>
 #include <iostream>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
 
 using fhicl::detail::throwOnSQLiteFailure;
 
-std::recursive_mutex fhicl::ParameterSetRegistry::mutex_{};
-
 namespace {
+  using steady_clock = std::chrono::steady_clock;
+
+  std::uint64_t
+  ns_since(steady_clock::time_point const start)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             steady_clock::now() - start)
+      .count();
+  }
+
+  std::size_t
+  wait_bucket(std::uint64_t const ns)
+  {
+    constexpr auto nbuckets = fhicl::ParameterSetRegistry::Statistics::nbuckets;
+    std::size_t result{1};
+    for (auto us = ns / 1000; us != 0 && result + 1 != nbuckets; us >>= 1) {
+      ++result;
+    }
+    return result;
+  }
+
+  void
+  count(std::atomic<std::uint64_t>& counter, std::uint64_t const n = 1)
+  {
+    counter.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  // Shared-cache in-memory DBs are visible process-wide by name, so
+  // the name is made unique to the registry: each copy of the library
+  // loaded into a process has its own.
+  std::string
+  primary_uri(void const* registry)
+  {
+    return "file:fhiclcpp_ParameterSetRegistry_" +
+           std::to_string(reinterpret_cast<std::uintptr_t>(registry)) +
+           "?mode=memory&cache=shared";
+  }
+
   sqlite3*
-  openPrimaryDB()
+  openPrimaryDB(std::string const& uri)
   {
     sqlite3* result = nullptr;
-    sqlite3_open(":memory:", &result);
+    sqlite3_open_v2(uri.c_str(),
+                    &result,
+                    SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE |
+                      SQLITE_OPEN_URI,
+                    nullptr);
     throwOnSQLiteFailure(result);
     using namespace cet::sqlite;
     Transaction txn{result};
@@ -35,6 +84,166 @@ namespace {
     txn.commit();
     return result;
   }
+
+  char const*
+  column_text(sqlite3_stmt* stmt, int const i)
+  {
+    auto const* text = sqlite3_column_text(stmt, i);
+    return text ? reinterpret_cast<char const*>(text) : "";
+  }
+
+  // Call f(id, psBlob) for each row of the ParameterSets table.
+  template <typename F>
+  void
+  for_each_row(sqlite3* db, F f)
+  {
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(
+      db, "SELECT ID, PSetBlob FROM ParameterSets;", -1, &stmt, nullptr);
+    throwOnSQLiteFailure(db);
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+      f(column_text(stmt, 0), column_text(stmt, 1));
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+      throwOnSQLiteFailure(db);
+    }
+  }
+
+  // IDs are normally stored with their terminating NUL (see the
+  // bindings below), but DBs written by other means may lack it.
+  constexpr char const* select_blob_sql{
+    "SELECT PSetBlob FROM ParameterSets WHERE ID IN (?1, ?2);"};
+
+  // Open a read-only connection and prepare its lookup statement.
+  void
+  open_for_lookup(char const* filename,
+                  int const flags,
+                  sqlite3*& db,
+                  sqlite3_stmt*& stmt)
+  {
+    sqlite3_open_v2(filename, &db, SQLITE_OPEN_READONLY | flags, nullptr);
+    try {
+      throwOnSQLiteFailure(db);
+      sqlite3_prepare_v2(db, select_blob_sql, -1, &stmt, nullptr);
+      throwOnSQLiteFailure(db);
+    }
+    catch (...) {
+      sqlite3_finalize(stmt);
+      sqlite3_close(db);
+      db = nullptr;
+      stmt = nullptr;
+      throw;
+    }
+  }
+
+  // Look up the blob for idString.
+  bool
+  select_blob(sqlite3* db,
+              sqlite3_stmt* stmt,
+              std::string const& idString,
+              std::string& psBlob)
+  {
+    sqlite3_bind_text(
+      stmt, 1, idString.c_str(), idString.size() + 1, SQLITE_STATIC);
+    throwOnSQLiteFailure(db);
+    sqlite3_bind_text(stmt, 2, idString.c_str(), idString.size(), SQLITE_STATIC);
+    throwOnSQLiteFailure(db);
+    bool found{false};
+    switch (sqlite3_step(stmt)) {
+    case SQLITE_ROW: // Found the ID in the DB.
+      psBlob = reinterpret_cast<char const*>(sqlite3_column_text(stmt, 0));
+      found = true;
+      break;
+    case SQLITE_DONE:
+      break; // Not here.
+    default:
+      throwOnSQLiteFailure(db);
+    }
+    sqlite3_reset(stmt);
+    return found;
+  }
+
+  // Call f(id, psBlob) for each row whose ID is in ids, querying in
+  // batches that respect SQLite's limit on bound parameters.  Returns
+  // the number of queries.
+  template <typename F>
+  std::size_t
+  select_blobs(sqlite3* db, std::vector<std::string> const& ids, F f)
+  {
+    constexpr std::size_t max_batch{256};
+    std::size_t queries{};
+    for (std::size_t first = 0; first < ids.size(); first += max_batch) {
+      ++queries;
+      auto const n = std::min(max_batch, ids.size() - first);
+      std::string sql{"SELECT ID, PSetBlob FROM ParameterSets WHERE ID IN (?"};
+      for (std::size_t i = 1; i != 2 * n; ++i) {
+        sql += ",?";
+      }
+      sql += ");";
+      sqlite3_stmt* stmt = nullptr;
+      sqlite3_prepare_v2(db, sql.c_str(), sql.size() + 1, &stmt, nullptr);
+      throwOnSQLiteFailure(db);
+      // As for select_blob, with and without the terminating NUL.
+      for (std::size_t i = 0; i != n; ++i) {
+        auto const& id = ids[first + i];
+        sqlite3_bind_text(
+          stmt, 2 * i + 1, id.c_str(), id.size() + 1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2 * i + 2, id.c_str(), id.size(), SQLITE_STATIC);
+      }
+      int rc;
+      while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        f(column_text(stmt, 0), column_text(stmt, 1));
+      }
+      sqlite3_finalize(stmt);
+      if (rc != SQLITE_DONE) {
+        throwOnSQLiteFailure(db);
+      }
+    }
+    return queries;
+  }
+
+  // The IDs of the nested tables to which a blob refers.
+  std::vector<std::string>
+  referenced_ids(std::string_view const psBlob)
+  {
+    constexpr std::string_view prefix{"@id::"};
+    constexpr auto size = fhicl::ParameterSetID::max_str_size();
+    std::vector<std::string> result;
+    for (auto pos = psBlob.find(prefix); pos != std::string_view::npos;
+         pos = psBlob.find(prefix, pos)) {
+      pos += prefix.size();
+      auto const id = psBlob.substr(pos, size);
+      if (id.size() == size &&
+          id.find_first_not_of("0123456789abcdef") == std::string_view::npos) {
+        result.emplace_back(id);
+        pos += size;
+      }
+    }
+    return result;
+  }
+
+  void
+  close(sqlite3* db, sqlite3_stmt* stmt)
+  {
+    if (db == nullptr) {
+      return;
+    }
+    sqlite3_finalize(stmt);
+    try {
+      throwOnSQLiteFailure(db);
+    }
+    catch (fhicl::exception const& e) {
+      std::cerr << e.what() << '\n';
+    }
+    catch (...) {
+    }
+    int retcode;
+    do {
+      retcode = sqlite3_close(db);
+    } while (retcode == SQLITE_BUSY);
+  }
 }
 
 void
@@ -64,29 +273,42 @@ fhicl::detail::throwOnSQLiteFailure(sqlite3* db, char* msg)
 
 fhicl::ParameterSetRegistry::~ParameterSetRegistry()
 {
-  sqlite3_finalize(stmt_);
-  try {
-    throwOnSQLiteFailure(primaryDB_);
-  }
-  catch (fhicl::exception const& e) {
-    std::cerr << e.what() << '\n';
-  }
-  catch (...) {
+  idle_readers_.clear();
+  close(primaryDB_, nullptr);
+}
+
+fhicl::ParameterSetRegistry::Reader::~Reader()
+{
+  for (auto const& source : sources) {
+    close(source.db, source.stmt);
   }
-  int retcode;
-  do {
-    retcode = sqlite3_close(primaryDB_);
-  } while (retcode == SQLITE_BUSY);
+  close(primary.db, primary.stmt);
 }
 
 void
-fhicl::ParameterSetRegistry::importFrom(sqlite3* db)
+fhicl::ParameterSetRegistry::importFrom(sqlite3* db, import_mode const mode)
 {
   assert(db);
-  std::lock_guard sentry{mutex_};
+  auto& reg = instance_();
+  std::lock_guard sentry{reg.db_mutex_};
 
   // This does *not* cause anything new to be imported into the
   // registry itself, just its backing DB.
+  if (mode == import_mode::lazy) {
+    char const* filename = sqlite3_db_filename(db, "main");
+    if (filename != nullptr && *filename != '\0') {
+      // The registry opens its own read-only connections, so the
+      // caller's handle may be closed.  Check now that the file has
+      // the expected table.
+      Source source;
+      open_for_lookup(filename, 0, source.db, source.stmt);
+      close(source.db, source.stmt);
+      reg.source_files_.emplace_back(filename);
+      return;
+    }
+    // In-memory and temporary DBs cannot be reopened: copy them.
+  }
+
   sqlite3_stmt* oStmt = nullptr;
   sqlite3* primaryDB = instance_().primaryDB_;
 
@@ -127,13 +349,26 @@ void
 fhicl::ParameterSetRegistry::exportTo(sqlite3* db)
 {
   assert(db);
-  std::lock_guard sentry{mutex_};
+  auto& reg = instance_();
+
+  // Gather the registered sets first: serializing one may look up
+  // others, so no shard lock may be held while doing so.  The copies
+  // share their contents with the entries, which may be evicted in the
+  // meantime.
+  std::vector<std::pair<ParameterSetID, ParameterSet>> entries;
+  for (auto const& shard : reg.shards_) {
+    std::shared_lock sentry{shard.mutex};
+    for (auto const& [id, ps] : shard.entries) {
+      entries.emplace_back(id, ps);
+    }
+  }
 
+  // All inserts happen in a single transaction: committing each row
+  // separately dominates the cost of writing a file-backed DB.
   cet::sqlite::Transaction txn{db};
   cet::sqlite::exec(db,
                     "DROP TABLE IF EXISTS ParameterSets;"
                     "CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);");
-  txn.commit();
 
   sqlite3_stmt* oStmt = nullptr;
   sqlite3_prepare_v2(
@@ -143,13 +378,13 @@ fhicl::ParameterSetRegistry::exportTo(sqlite3* db)
     &oStmt,
     nullptr);
   throwOnSQLiteFailure(db);
-  for (auto const& p : instance_().registry_) {
-    std::string id(p.first.to_string());
-    std::string psBlob(p.second.to_compact_string());
-    sqlite3_bind_text(oStmt, 1, id.c_str(), id.size() + 1, SQLITE_STATIC);
+  auto insert = [db, oStmt](char const* id,
+                            std::size_t const idSize,
+                            char const* psBlob,
+                            std::size_t const psBlobSize) {
+    sqlite3_bind_text(oStmt, 1, id, idSize + 1, SQLITE_STATIC);
     throwOnSQLiteFailure(db);
-    sqlite3_bind_text(
-      oStmt, 2, psBlob.c_str(), psBlob.size() + 1, SQLITE_STATIC);
+    sqlite3_bind_text(oStmt, 2, psBlob, psBlobSize + 1, SQLITE_STATIC);
     throwOnSQLiteFailure(db);
     switch (sqlite3_step(oStmt)) {
     case SQLITE_DONE:
@@ -159,91 +394,795 @@ fhicl::ParameterSetRegistry::exportTo(sqlite3* db)
     default:
       throwOnSQLiteFailure(db);
     }
-  }
+  };
 
-  sqlite3* const primaryDB{instance_().primaryDB_};
-  using namespace cet::sqlite;
-  query_result<std::string, std::string> regPSes;
-  regPSes << select("*").from(primaryDB, "ParameterSets");
+  // Copy the backing DB first, remembering its IDs so that registry
+  // entries it already holds are not serialized only to be ignored.
+  std::unordered_set<std::string> exported;
+  auto copy_row = [&exported, &insert](char const* id, char const* psBlob) {
+    auto const [it, is_new] = exported.emplace(id);
+    if (is_new) {
+      insert(it->c_str(), it->size(), psBlob, std::strlen(psBlob));
+    }
+  };
+  {
+    auto reader = reg.acquire_reader_();
+    std::shared_lock sentry{reg.db_mutex_};
+    reg.sync_reader_(*reader);
+    for_each_row(reader->primary.db, copy_row);
+    for (auto const& source : reader->sources) {
+      for_each_row(source.db, copy_row);
+    }
+    reg.release_reader_(std::move(reader));
+  }
 
-  for (auto const& [idString, psBlob] : regPSes) {
-    sqlite3_bind_text(
-      oStmt, 1, idString.c_str(), idString.size() + 1, SQLITE_STATIC);
-    throwOnSQLiteFailure(db);
-    sqlite3_bind_text(
-      oStmt, 2, psBlob.c_str(), psBlob.size() + 1, SQLITE_STATIC);
-    throwOnSQLiteFailure(db);
-    switch (sqlite3_step(oStmt)) {
-    case SQLITE_DONE:
-      sqlite3_reset(oStmt);
-      throwOnSQLiteFailure(db);
-      break; // OK
-    default:
-      throwOnSQLiteFailure(db);
+  for (auto const& [psid, ps] : entries) {
+    std::string id(psid.to_string());
+    if (exported.count(id) != 0) {
+      continue;
     }
+    std::string psBlob(ps.to_compact_string());
+    insert(id.c_str(), id.size(), psBlob.c_str(), psBlob.size());
   }
   sqlite3_finalize(oStmt);
   throwOnSQLiteFailure(db);
+  txn.commit();
 }
 
 void
 fhicl::ParameterSetRegistry::stageIn()
 {
-  std::lock_guard sentry{mutex_};
+  auto& reg = instance_();
+  std::vector<std::pair<ParameterSetID, std::string>> entriesToStageIn;
+  {
+    std::unordered_set<std::string> seen;
+    auto stage_row = [&seen, &entriesToStageIn](char const* id,
+                                                char const* psBlob) {
+      if (!seen.emplace(id).second) {
+        return;
+      }
+      ParameterSetID psid{id};
+      if (!has(psid)) {
+        entriesToStageIn.emplace_back(psid, psBlob);
+      }
+    };
+    auto reader = reg.acquire_reader_();
+    std::shared_lock sentry{reg.db_mutex_};
+    reg.sync_reader_(*reader);
+    for_each_row(reader->primary.db, stage_row);
+    for (auto const& source : reader->sources) {
+      for_each_row(source.db, stage_row);
+    }
+    reg.release_reader_(std::move(reader));
+  }
 
-  sqlite3* primaryDB = instance_().primaryDB_;
-  auto& registry = instance_().registry_;
-  using namespace cet::sqlite;
-  query_result<std::string, std::string> entriesToStageIn;
-  entriesToStageIn << select("*").from(primaryDB, "ParameterSets");
+  // Parsing dominates, and is done in parallel with no lock held.
+  // Each result lands in its row's slot so that the merge below does
+  // not depend on scheduling.
+  std::vector<ParameterSet> staged(entriesToStageIn.size());
+  tbb::parallel_for(
+    tbb::blocked_range<std::size_t>{0, entriesToStageIn.size()},
+    [&entriesToStageIn, &staged](auto const& range) {
+      for (auto i = range.begin(); i != range.end(); ++i) {
+        staged[i] = ParameterSet::make(entriesToStageIn[i].second);
+      }
+    });
 
-  cet::transform_all(entriesToStageIn,
-                     std::inserter(registry, std::begin(registry)),
-                     [](auto const& row) {
-                       auto const& [idString, psBlob] = row;
-                       auto const pset = ParameterSet::make(psBlob);
-                       return std::make_pair(ParameterSetID{idString}, pset);
-                     });
+  // Merge, taking each shard's lock once.  As for find_, these are not
+  // puts and so are not subject to the frozen_put_policy.
+  std::array<std::vector<std::size_t>, nshards> by_shard;
+  for (std::size_t i = 0; i != entriesToStageIn.size(); ++i) {
+    by_shard[shard_index_(entriesToStageIn[i].first)].push_back(i);
+  }
+  for (std::size_t s = 0; s != by_shard.size(); ++s) {
+    if (by_shard[s].empty()) {
+      continue;
+    }
+    auto& shard = reg.shards_[s];
+    auto const sentry =
+      lock_<std::unique_lock<std::shared_mutex>>(shard, reg.counters_());
+    for (auto const i : by_shard[s]) {
+      auto const& id = entriesToStageIn[i].first;
+      auto const [it, inserted] =
+        shard.entries.try_emplace(id, std::move(staged[i]));
+      if (inserted) {
+        shard.spilled.erase(id);
+        reg.track_(shard, id, it->second, true);
+      }
+    }
+  }
+  reg.evict_();
+}
+
+bool
+fhicl::ParameterSetRegistry::has(ParameterSetID const& id)
+{
+  auto& reg = instance_();
+  auto& counters = reg.counters_();
+  if (FrozenReader{reg, counters}.find(id) != nullptr) {
+    return true;
+  }
+  auto const& shard = reg.shard_(id);
+  auto const sentry =
+    lock_<std::shared_lock<std::shared_mutex>>(shard, counters);
+  return shard.entries.find(id) != shard.entries.cend() ||
+         shard.spilled.find(id) != shard.spilled.cend();
+}
+
+bool
+fhicl::ParameterSetRegistry::empty()
+{
+  for (auto const& shard : instance_().shards_) {
+    std::shared_lock sentry{shard.mutex};
+    if (!shard.entries.empty() || !shard.spilled.empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+auto
+fhicl::ParameterSetRegistry::size() -> size_type
+{
+  size_type result{};
+  for (auto const& shard : instance_().shards_) {
+    std::shared_lock sentry{shard.mutex};
+    result += shard.entries.size() + shard.spilled.size();
+  }
+  return result;
+}
+
+auto
+fhicl::ParameterSetRegistry::counters_() noexcept -> Counters&
+{
+  // Threads take the sets of counters in turn, so that concurrent
+  // lookups increment counters on different cache lines.
+  static std::atomic<std::size_t> next{};
+  thread_local std::size_t const index{
+    next.fetch_add(1, std::memory_order_relaxed) % ncounters};
+  return thread_counters_[index];
+}
+
+template <typename Lock>
+Lock
+fhicl::ParameterSetRegistry::lock_(Shard const& shard, Counters& counters)
+{
+  // Only contended locks are timed, so that the common case costs one
+  // counter increment.
+  Lock lock{shard.mutex, std::try_to_lock};
+  if (lock.owns_lock()) {
+    count(counters.lock_waits[0]);
+    return lock;
+  }
+  auto const start = steady_clock::now();
+  lock.lock();
+  auto const ns = ns_since(start);
+  count(counters.lock_waits[wait_bucket(ns)]);
+  count(counters.lock_wait_ns, ns);
+  return lock;
+}
+
+auto
+fhicl::ParameterSetRegistry::statistics() -> Statistics
+{
+  Statistics result{};
+  for (auto const& c : instance_().thread_counters_) {
+    result.lookups += c.lookups.load(std::memory_order_relaxed);
+    result.hits += c.hits.load(std::memory_order_relaxed);
+    result.fallbacks += c.fallbacks.load(std::memory_order_relaxed);
+    result.prefetched += c.prefetched.load(std::memory_order_relaxed);
+    result.queries += c.queries.load(std::memory_order_relaxed);
+    result.parse_ns += c.parse_ns.load(std::memory_order_relaxed);
+    result.puts += c.puts.load(std::memory_order_relaxed);
+    result.duplicate_puts += c.duplicate_puts.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i != Statistics::nbuckets; ++i) {
+      result.lock_waits[i] += c.lock_waits[i].load(std::memory_order_relaxed);
+    }
+    result.lock_wait_ns += c.lock_wait_ns.load(std::memory_order_relaxed);
+  }
+  // Counters are read one at a time, so a hit may be seen before its
+  // lookup.
+  result.misses =
+    result.lookups > result.hits ? result.lookups - result.hits : 0;
+  return result;
+}
+
+void
+fhicl::ParameterSetRegistry::resetStatistics()
+{
+  for (auto& c : instance_().thread_counters_) {
+    for (auto* counter : {&c.lookups,
+                          &c.hits,
+                          &c.fallbacks,
+                          &c.prefetched,
+                          &c.queries,
+                          &c.parse_ns,
+                          &c.puts,
+                          &c.duplicate_puts,
+                          &c.lock_wait_ns}) {
+      counter->store(0, std::memory_order_relaxed);
+    }
+    for (auto& counter : c.lock_waits) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+std::ostream&
+fhicl::operator<<(std::ostream& os,
+                  ParameterSetRegistry::Statistics const& stats)
+{
+  using Statistics = ParameterSetRegistry::Statistics;
+  os << "ParameterSetRegistry statistics:\n"
+     << "  lookups:      " << stats.lookups << " (hits: " << stats.hits
+     << ", misses: " << stats.misses << ")\n"
+     << "  DB fallbacks: " << stats.fallbacks
+     << " (prefetched: " << stats.prefetched
+     << ", queries: " << stats.queries
+     << ", parse time: " << stats.parse_ns / 1000 << " us)\n"
+     << "  puts:         " << stats.puts
+     << " (duplicates: " << stats.duplicate_puts << ")\n"
+     << "  shard locks:  " << stats.lock_waits[0] << " uncontended, "
+     << stats.lock_wait_ns / 1000 << " us spent waiting\n";
+  for (std::size_t i = 1; i != Statistics::nbuckets; ++i) {
+    if (stats.lock_waits[i] == 0) {
+      continue;
+    }
+    auto const bound = std::uint64_t{1} << (i - 1);
+    if (i + 1 == Statistics::nbuckets) {
+      os << "    >= " << bound / 2;
+    } else {
+      os << "    <  " << bound;
+    }
+    os << " us: " << stats.lock_waits[i] << '\n';
+  }
+  return os;
+}
+
+void
+fhicl::ParameterSetRegistry::freeze(frozen_put_policy const policy)
+{
+  auto& reg = instance_();
+  std::lock_guard sentry{reg.maintenance_mutex_};
+
+  std::vector<std::pair<ParameterSetID, ParameterSet>> entries;
+  for (auto const& shard : reg.shards_) {
+    std::shared_lock shard_sentry{shard.mutex};
+    for (auto const& [id, ps] : shard.entries) {
+      entries.emplace_back(id, ps);
+    }
+  }
+  std::sort(entries.begin(), entries.end(), [](auto const& a, auto const& b) {
+    return a.first < b.first;
+  });
+
+  auto table = std::make_unique<FrozenTable>();
+  table->ids.reserve(entries.size());
+  table->psets.reserve(entries.size());
+  for (auto& [id, ps] : entries) {
+    table->ids.push_back(id);
+    table->psets.push_back(std::move(ps));
+  }
+
+  reg.frozen_policy_.store(policy);
+  auto const retired = std::move(reg.frozen_table_);
+  reg.frozen_table_ = std::move(table);
+  reg.frozen_.store(reg.frozen_table_.get());
+  if (!retired) {
+    return;
+  }
+  // Lookups that began before the store may still be reading the
+  // earlier table; those that began after it cannot see it.
+  for (auto const& counters : reg.thread_counters_) {
+    while (counters.frozen_readers.load() != 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+fhicl::ParameterSetRegistry::FrozenReader::FrozenReader(
+  ParameterSetRegistry const& reg,
+  Counters& counters) noexcept
+  : readers_{counters.frozen_readers}
+{
+  // Both sequentially consistent, as is the store in freeze(): either
+  // this reads the new table, or freeze() sees this reader.
+  readers_.fetch_add(1);
+  table_ = reg.frozen_.load();
+}
+
+fhicl::ParameterSetRegistry::FrozenReader::~FrozenReader()
+{
+  readers_.fetch_sub(1, std::memory_order_release);
+}
+
+auto
+fhicl::ParameterSetRegistry::FrozenReader::find(
+  ParameterSetID const& id) const noexcept -> ParameterSet const*
+{
+  if (table_ == nullptr) {
+    return nullptr;
+  }
+  auto const i = table_->index(id);
+  return i == table_->ids.size() ? nullptr : &table_->psets[i];
+}
+
+std::size_t
+fhicl::ParameterSetRegistry::FrozenTable::index(
+  ParameterSetID const& id) const noexcept
+{
+  auto const it = std::lower_bound(ids.cbegin(), ids.cend(), id);
+  return (it != ids.cend() && *it == id) ? it - ids.cbegin() : ids.size();
+}
+
+auto
+fhicl::ParameterSetRegistry::get() -> collection_type
+{
+  collection_type result;
+  for (auto const& shard : instance_().shards_) {
+    std::shared_lock sentry{shard.mutex};
+    result.insert(shard.entries.cbegin(), shard.entries.cend());
+  }
+  return result;
 }
 
 fhicl::ParameterSetRegistry::ParameterSetRegistry()
-  : primaryDB_{openPrimaryDB()}
+  : primary_location_{primary_uri(this)}
+  , primaryDB_{openPrimaryDB(primary_location_)}
 {}
 
 auto
-fhicl::ParameterSetRegistry::find_(ParameterSetID const& id) -> const_iterator
-{
-  // No lock here -- it was already acquired by get(...).
-  auto it = registry_.find(id);
-  if (it == registry_.cend()) {
-    // Look in primary DB for this ID and its contained IDs.
-    if (stmt_ == nullptr) {
-      sqlite3_prepare_v2(primaryDB_,
-                         "SELECT PSetBlob FROM ParameterSets WHERE ID = ?;",
-                         -1,
-                         &stmt_,
-                         nullptr);
-      throwOnSQLiteFailure(primaryDB_);
-    }
-    auto idString = id.to_string();
-    auto result = sqlite3_bind_text(
-      stmt_, 1, idString.c_str(), idString.size() + 1, SQLITE_STATIC);
-    throwOnSQLiteFailure(primaryDB_);
-    result = sqlite3_step(stmt_);
-    switch (result) {
-    case SQLITE_ROW: // Found the ID in the DB.
+fhicl::ParameterSetRegistry::insert_(ParameterSetID const& id,
+                                     ParameterSet const& ps)
+  -> ParameterSetID
+{
+  auto& shard = shard_(id);
+  auto& counters = counters_();
+  count(counters.puts);
+  if (FrozenReader const frozen{*this, counters}; frozen.table()) {
+    if (frozen.find(id) != nullptr) {
+      count(counters.duplicate_puts);
+      return id;
+    }
+    if (frozen_policy_.load() == frozen_put_policy::reject) {
+      throw exception(error::cant_insert, "ParameterSetRegistry is frozen")
+        << "Can't register ParameterSet with ID " << id.to_string()
+        << " after freeze().";
+    }
+  }
+  {
+    auto const sentry =
+      lock_<std::unique_lock<std::shared_mutex>>(shard, counters);
+    auto const [it, inserted] = shard.entries.try_emplace(id, ps);
+    if (inserted) {
+      track_(shard, id, ps, shard.spilled.erase(id) != 0);
+    } else {
+      count(counters.duplicate_puts);
+      touch_(shard, id);
+    }
+  }
+  evict_();
+  return id;
+}
+
+auto
+fhicl::ParameterSetRegistry::acquire_reader_() -> std::unique_ptr<Reader>
+{
+  {
+    std::lock_guard sentry{pool_mutex_};
+    if (!idle_readers_.empty()) {
+      auto reader = std::move(idle_readers_.back());
+      idle_readers_.pop_back();
+      return reader;
+    }
+  }
+  // Connections are opened by sync_reader_.
+  return std::make_unique<Reader>();
+}
+
+void
+fhicl::ParameterSetRegistry::release_reader_(std::unique_ptr<Reader> reader)
+{
+  std::lock_guard sentry{pool_mutex_};
+  idle_readers_.push_back(std::move(reader));
+}
+
+void
+fhicl::ParameterSetRegistry::sync_reader_(Reader& reader)
+{
+  // No lock here -- db_mutex_ was already acquired by the caller.
+  if (reader.primary_generation != primary_generation_) {
+    close(reader.primary.db, reader.primary.stmt);
+    reader.primary = {};
+    open_for_lookup(primary_location_.c_str(),
+                    SQLITE_OPEN_URI,
+                    reader.primary.db,
+                    reader.primary.stmt);
+    reader.primary_generation = primary_generation_;
+  }
+  while (reader.sources.size() < source_files_.size()) {
+    Source source;
+    open_for_lookup(source_files_[reader.sources.size()].c_str(),
+                    0,
+                    source.db,
+                    source.stmt);
+    reader.sources.push_back(source);
+  }
+}
+
+void
+fhicl::ParameterSetRegistry::prefetch_(Reader& reader,
+                                       std::string const& psBlob,
+                                       Counters& counters)
+{
+  // No lock here -- db_mutex_ was already acquired by find_(...).
+  std::unordered_map<ParameterSetID, std::string, detail::HashParameterSetID>
+    fetched;
+  std::vector<std::string> pending;
+  std::unordered_set<std::string> seen;
+  // Children already fetched (by this or another lookup) or
+  // registered are skipped.
+  auto add_children = [this, &pending, &seen](std::string_view const blob) {
+    std::vector<ParameterSetID> children;
+    for (auto& idString : referenced_ids(blob)) {
+      if (seen.insert(idString).second) {
+        children.emplace_back(idString);
+      }
+    }
     {
-      auto const pset = ParameterSet::make(
-        reinterpret_cast<char const*>(sqlite3_column_text(stmt_, 0)));
-      // Put into the registry without triggering ParameterSet::id().
-      it = registry_.emplace(id, pset).first;
-    } break;
-    case SQLITE_DONE:
-      break; // Not here.
-    default:
-      throwOnSQLiteFailure(primaryDB_);
+      std::lock_guard sentry{pool_mutex_};
+      children.erase(std::remove_if(children.begin(),
+                                    children.end(),
+                                    [this](auto const& child) {
+                                      return prefetched_.count(child) != 0;
+                                    }),
+                     children.end());
+    }
+    for (auto const& child : children) {
+      if (!has(child)) {
+        pending.push_back(child.to_string());
+      }
+    }
+  };
+  add_children(psBlob);
+
+  // One query per DB and generation of descendants.
+  while (!pending.empty()) {
+    auto const generation = std::move(pending);
+    pending.clear();
+    std::unordered_set<std::string> missing(generation.cbegin(),
+                                            generation.cend());
+    auto fetch_from = [&missing, &fetched, &add_children, &counters](
+                        sqlite3* db) {
+      std::vector<std::string> const ids(missing.cbegin(), missing.cend());
+      count(counters.queries,
+            select_blobs(db, ids, [&](char const* id, char const* blob) {
+              if (missing.erase(id) != 0) {
+                fetched.try_emplace(ParameterSetID{id}, blob);
+                add_children(blob);
+              }
+            }));
+    };
+    fetch_from(reader.primary.db);
+    for (auto it = reader.sources.cbegin(), e = reader.sources.cend();
+         !missing.empty() && it != e;
+         ++it) {
+      fetch_from(it->db);
+    }
+  }
+
+  if (fetched.empty()) {
+    return;
+  }
+  std::size_t bytes{};
+  for (auto const& [id, blob] : fetched) {
+    bytes += blob.size();
+  }
+  std::lock_guard sentry{pool_mutex_};
+  prefetched_.merge(fetched);
+  // Blobs another lookup fetched meanwhile are left behind.
+  for (auto const& [id, blob] : fetched) {
+    bytes -= blob.size();
+  }
+  prefetched_bytes_ += bytes;
+}
+
+auto
+fhicl::ParameterSetRegistry::find_(ParameterSetID const& id)
+  -> std::optional<ParameterSet>
+{
+  // Only this thread's counters are written, so the frozen table is
+  // read without touching any shared cache line.
+  auto& counters = counters_();
+  count(counters.lookups);
+  {
+    FrozenReader const frozen{*this, counters};
+    if (auto const* ps = frozen.find(id)) {
+      count(counters.hits);
+      return *ps;
     }
-    sqlite3_reset(stmt_);
   }
-  return it;
+
+  auto& shard = shard_(id);
+
+  // The entry is copied while the shard is locked: once the lock is
+  // released, it may be evicted.
+  {
+    auto const sentry =
+      lock_<std::shared_lock<std::shared_mutex>>(shard, counters);
+    auto it = shard.entries.find(id);
+    if (it != shard.entries.cend()) {
+      count(counters.hits);
+      touch_(shard, id);
+      return it->second;
+    }
+  }
+
+  // Look in primary DB for this ID and its contained IDs, then in
+  // the lazily-imported sources.  Only the pool of Readers is locked
+  // exclusively, and only briefly.  The children of a prefetched blob
+  // were fetched along with it, so they are not looked for again.
+  std::string psBlob;
+  bool found{false};
+  {
+    std::lock_guard sentry{pool_mutex_};
+    if (auto node = prefetched_.extract(id)) {
+      psBlob = std::move(node.mapped());
+      prefetched_bytes_ -= psBlob.size();
+      found = true;
+      count(counters.prefetched);
+    }
+  }
+  if (!found) {
+    auto reader = acquire_reader_();
+    {
+      std::shared_lock sentry{db_mutex_};
+      sync_reader_(*reader);
+      auto const idString = id.to_string();
+      count(counters.queries);
+      found =
+        select_blob(reader->primary.db, reader->primary.stmt, idString, psBlob);
+      for (auto it = reader->sources.cbegin(), e = reader->sources.cend();
+           !found && it != e;
+           ++it) {
+        count(counters.queries);
+        found = select_blob(it->db, it->stmt, idString, psBlob);
+      }
+      if (found) {
+        prefetch_(*reader, psBlob, counters);
+      }
+    }
+    release_reader_(std::move(reader));
+  }
+  if (!found) {
+    return std::nullopt;
+  }
+
+  // Making the ParameterSet may itself consult the registry, so no
+  // lock is held here.  Should another thread have got here first,
+  // its entry is kept.
+  count(counters.fallbacks);
+  auto const start = steady_clock::now();
+  auto const pset = ParameterSet::make(psBlob);
+  count(counters.parse_ns, ns_since(start));
+  // Put into the registry without triggering ParameterSet::id().
+  std::optional<ParameterSet> result;
+  {
+    auto const sentry =
+      lock_<std::unique_lock<std::shared_mutex>>(shard, counters);
+    auto const [it, inserted] = shard.entries.try_emplace(id, pset);
+    if (inserted) {
+      shard.spilled.erase(id);
+      track_(shard, id, pset, true);
+    }
+    result = it->second;
+  }
+  evict_();
+  return result;
+}
+
+void
+fhicl::ParameterSetRegistry::track_(Shard& shard,
+                                    ParameterSetID const& id,
+                                    ParameterSet const& ps,
+                                    bool const in_db)
+{
+  // No lock here -- the shard was already locked exclusively.
+  if (!tracking_.load()) {
+    return;
+  }
+  auto const bytes = ps.footprint_();
+  auto const [it, inserted] = shard.usage.try_emplace(id, bytes, in_db);
+  if (inserted) {
+    it->second.last_used.store(clock_.fetch_add(1, std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+    resident_bytes_ += bytes;
+  }
+}
+
+void
+fhicl::ParameterSetRegistry::touch_(Shard const& shard,
+                                    ParameterSetID const& id) const noexcept
+{
+  // No lock here -- the shard was already locked (possibly shared).
+  if (!tracking_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  if (auto it = shard.usage.find(id); it != shard.usage.cend()) {
+    it->second.last_used.store(clock_.load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+  }
+}
+
+void
+fhicl::ParameterSetRegistry::evict_()
+{
+  auto const budget = budget_.load();
+  if (budget == 0 ||
+      resident_bytes_.load() + prefetched_bytes_.load() <= budget) {
+    return;
+  }
+  // Writing out victims may look up (and so insert) other entries:
+  // evict_ must not re-enter itself, nor wait for another thread
+  // already evicting.
+  if (evicting_.exchange(true)) {
+    return;
+  }
+  struct Reset {
+    std::atomic<bool>& flag;
+    ~Reset() { flag = false; }
+  } const reset{evicting_};
+  std::lock_guard sentry{maintenance_mutex_};
+
+  // Prefetched blobs are already in a DB, and so are dropped first.
+  {
+    std::lock_guard pool_sentry{pool_mutex_};
+    prefetched_.clear();
+    prefetched_bytes_ = 0;
+  }
+  if (resident_bytes_.load() <= budget) {
+    return;
+  }
+
+  // Victims are copied, so that writing them out needs no lock.
+  struct Victim {
+    std::uint64_t last_used;
+    ParameterSetID id;
+    ParameterSet ps;
+    std::size_t bytes;
+    bool in_db;
+  };
+  std::vector<Victim> victims;
+  // Holding maintenance_mutex_, the frozen table cannot be replaced.
+  auto const* table = frozen_table_.get();
+  for (auto const& shard : shards_) {
+    std::shared_lock shard_sentry{shard.mutex};
+    for (auto const& [id, usage] : shard.usage) {
+      if (table != nullptr && table->index(id) != table->ids.size()) {
+        continue;
+      }
+      victims.push_back({usage.last_used.load(std::memory_order_relaxed),
+                         id,
+                         shard.entries.find(id)->second,
+                         usage.bytes,
+                         usage.in_db});
+    }
+  }
+
+  // Least recently used first, down to 7/8 of the budget.
+  std::sort(victims.begin(), victims.end(), [](auto const& a, auto const& b) {
+    return a.last_used < b.last_used;
+  });
+  auto const excess = resident_bytes_.load() - (budget - budget / 8);
+  std::size_t n{};
+  for (std::size_t freed{}; n != victims.size() && freed < excess; ++n) {
+    freed += victims[n].bytes;
+  }
+  victims.resize(n);
+
+  std::vector<std::pair<std::string, std::string>> rows;
+  for (auto const& victim : victims) {
+    if (!victim.in_db) {
+      rows.emplace_back(victim.id.to_string(), victim.ps.to_compact_string());
+    }
+  }
+  if (!rows.empty()) {
+    std::lock_guard db_sentry{db_mutex_};
+    cet::sqlite::Transaction txn{primaryDB_};
+    sqlite3_stmt* oStmt = nullptr;
+    sqlite3_prepare_v2(
+      primaryDB_,
+      "INSERT OR IGNORE INTO ParameterSets(ID, PSetBlob) VALUES(?, ?);",
+      -1,
+      &oStmt,
+      nullptr);
+    throwOnSQLiteFailure(primaryDB_);
+    for (auto const& [idString, psBlob] : rows) {
+      sqlite3_bind_text(
+        oStmt, 1, idString.c_str(), idString.size() + 1, SQLITE_STATIC);
+      sqlite3_bind_text(
+        oStmt, 2, psBlob.c_str(), psBlob.size() + 1, SQLITE_STATIC);
+      if (sqlite3_step(oStmt) != SQLITE_DONE) {
+        sqlite3_finalize(oStmt);
+        throwOnSQLiteFailure(primaryDB_);
+      }
+      sqlite3_reset(oStmt);
+    }
+    sqlite3_finalize(oStmt);
+    txn.commit();
+  }
+
+  for (auto const& victim : victims) {
+    auto& shard = shard_(victim.id);
+    std::lock_guard shard_sentry{shard.mutex};
+    if (shard.entries.erase(victim.id) == 0) {
+      continue;
+    }
+    shard.usage.erase(victim.id);
+    shard.spilled.insert(victim.id);
+    resident_bytes_ -= victim.bytes;
+  }
+}
+
+void
+fhicl::ParameterSetRegistry::setMemoryBudget(std::size_t const bytes)
+{
+  auto& reg = instance_();
+  if (bytes != 0 && !reg.tracking_.exchange(true)) {
+    // Account for the entries registered so far.
+    for (auto& shard : reg.shards_) {
+      std::lock_guard sentry{shard.mutex};
+      for (auto const& [id, ps] : shard.entries) {
+        reg.track_(shard, id, ps, false);
+      }
+    }
+  }
+  reg.budget_ = bytes;
+  reg.evict_();
+}
+
+void
+fhicl::ParameterSetRegistry::spillTo(std::string const& filename)
+{
+  auto& reg = instance_();
+  std::lock_guard sentry{reg.db_mutex_};
+  sqlite3* file = nullptr;
+  sqlite3_open_v2(filename.c_str(),
+                  &file,
+                  SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE,
+                  nullptr);
+  try {
+    throwOnSQLiteFailure(file);
+    auto* backup = sqlite3_backup_init(file, "main", reg.primaryDB_, "main");
+    if (backup == nullptr) {
+      throwOnSQLiteFailure(file);
+    }
+    sqlite3_backup_step(backup, -1);
+    throwOnSQLiteFailure(sqlite3_backup_finish(backup));
+  }
+  catch (...) {
+    sqlite3_close(file);
+    throw;
+  }
+  close(reg.primaryDB_, nullptr);
+  reg.primaryDB_ = file;
+  reg.primary_location_ = filename;
+  ++reg.primary_generation_;
+
+  // Idle Readers would only reconnect on next use.
+  std::lock_guard pool_sentry{reg.pool_mutex_};
+  reg.idle_readers_.clear();
+}
+
+auto
+fhicl::ParameterSetRegistry::memoryUsage() -> MemoryUsage
+{
+  auto& reg = instance_();
+  MemoryUsage result{reg.budget_.load(), 0, reg.resident_bytes_.load(), 0};
+  for (auto const& shard : reg.shards_) {
+    std::shared_lock sentry{shard.mutex};
+    result.resident_entries += shard.entries.size();
+    result.spilled_entries += shard.spilled.size();
+  }
+  return result;
 }
@@ -12,8 +12,20 @@
 #include "fhiclcpp/exception.h"
 #include "fhiclcpp/fwd.h"
 
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 struct sqlite3;
 struct sqlite3_stmt;
@@ -31,10 +43,7 @@ namespace fhicl {
 
 class fhicl::detail::HashParameterSetID {
 public:
-  size_t operator()(ParameterSetID const& id) const;
-
-private:
-  std::hash<std::string> hash_;
+  size_t operator()(ParameterSetID const& id) const noexcept;
 };
 
 class fhicl::ParameterSetRegistry {
@@ -55,17 +64,90 @@ public:
   using const_iterator = collection_type::const_iterator;
 
   // DB interaction.
-  static void importFrom(sqlite3* db);
+  //
+  // With import_mode::copy, the ParameterSets table of db is copied
+  // into the registry's backing DB.  With import_mode::lazy, the file
+  // behind db is instead opened read-only and consulted only when an ID
+  // is looked up; the file must then remain readable (and any writes to
+  // it be committed) for the lifetime of the registry.  DBs with no
+  // file (e.g. ":memory:") are always copied.
+  enum class import_mode { copy, lazy };
+  static void importFrom(sqlite3* db, import_mode mode = import_mode::copy);
   static void exportTo(sqlite3* db);
   static void stageIn();
 
-  // Observers.
+  // Observers.  Entries spilled to the backing DB (see below) count
+  // as registered.
   static bool empty();
   static size_type size();
 
+  // Memory bounding.
+  //
+  // With a nonzero budget, once the estimated size of the resident
+  // ParameterSets exceeds it, the least recently used entries are
+  // written to the backing DB (if not already there) and evicted; they
+  // are read back in on demand.  Entries in a frozen table are never
+  // evicted.  Blobs prefetched from a DB but not yet looked up count
+  // against the budget too, and are the first to be dropped.
+  //
+  // spillTo moves the backing DB from memory to the named file, which
+  // is overwritten.
+  struct MemoryUsage {
+    std::size_t budget;
+    std::size_t resident_entries;
+    std::size_t resident_bytes;
+    std::size_t spilled_entries;
+  };
+  static void setMemoryBudget(std::size_t bytes);
+  static void spillTo(std::string const& filename);
+  static MemoryUsage memoryUsage();
+
+  // Statistics.
+  //
+  // Collection is always on: the counters are relaxed atomics kept per
+  // thread (threads share them only once there are more threads than
+  // sets of counters), and a shard lock is timed only when it could not
+  // be taken at once.  A lookup is a call to get(id); it misses when
+  // the entry is not resident, and then falls back to a (possibly
+  // prefetched) blob from a DB if there is one.  queries counts the
+  // statements run against a DB to that end, prefetching included.
+  // lock_waits[0] counts shard locks taken without waiting;
+  // lock_waits[i] counts waits shorter than 2^(i-1) microseconds (and
+  // not counted in an earlier bucket), the last bucket being unbounded.
+  struct Statistics {
+    static constexpr std::size_t nbuckets{16};
+    std::uint64_t lookups;
+    std::uint64_t hits;
+    std::uint64_t misses;
+    std::uint64_t fallbacks;
+    std::uint64_t prefetched;
+    std::uint64_t queries;
+    std::uint64_t parse_ns;
+    std::uint64_t puts;
+    std::uint64_t duplicate_puts;
+    std::array<std::uint64_t, nbuckets> lock_waits;
+    std::uint64_t lock_wait_ns;
+  };
+  static Statistics statistics();
+  static void resetStatistics();
+
+  // Freezing.
+  //
+  // Once all ParameterSets of interest have been registered, freeze()
+  // compacts the registry into an immutable sorted table that is then
+  // consulted without taking any lock.  Puts of IDs already in the
+  // table always succeed; puts of new IDs either go to the (locked)
+  // overflow shards or throw, according to the policy.  Entries read
+  // in from the backing DB are not puts and always go to overflow.
+  // Calling freeze() again folds the overflow into a new table; the
+  // table it replaces is destroyed as soon as no lookup is reading it.
+  enum class frozen_put_policy { overflow, reject };
+  static void freeze(frozen_put_policy policy = frozen_put_policy::overflow);
+  static bool frozen() noexcept;
+
   // Put:
   // 1. A single ParameterSet.
-  static ParameterSetID const& put(ParameterSet const& ps);
+  static ParameterSetID put(ParameterSet const& ps);
   // 2. A range of iterator to ParameterSet.
   template <class FwdIt>
   static std::enable_if_t<
@@ -84,43 +166,171 @@ public:
   static void put(collection_type const& c);
 
   // Accessors.
-  static collection_type const& get() noexcept;
-  static ParameterSet const& get(ParameterSetID const& id);
+  //
+  // get() returns a copy of the resident registry contents, taken
+  // shard by shard at the time of the call.  get(id) returns a copy of
+  // the entry, which shares its contents (see ParameterSet) and so
+  // remains valid should the entry be evicted.
+  static collection_type get();
+  static ParameterSet get(ParameterSetID const& id);
   static bool get(ParameterSetID const& id, ParameterSet& ps);
   static bool has(ParameterSetID const& id);
 
 private:
+  // Entries are spread over independently-locked shards, selected by
+  // the digest, so that lookups from different threads neither
+  // serialize on a single lock nor block each other while reading.
+  // The backing DB has its own lock, which is never held while a
+  // ParameterSet is being made (making one may re-enter the registry).
+  static constexpr unsigned shard_bits{6};
+  static constexpr std::size_t nshards{1u << shard_bits};
+
+  // Bookkeeping for an entry, kept only once a memory budget has
+  // been set.
+  struct Usage {
+    explicit Usage(std::size_t const bytes, bool const in_db)
+      : bytes{bytes}, in_db{in_db}
+    {}
+    mutable std::atomic<std::uint64_t> last_used{};
+    std::size_t bytes;
+    bool in_db; // Already in the backing DB: can be evicted for free.
+  };
+
+  // Each set of counters has cache lines of its own, so that threads
+  // reading the same entries do not write the same line.
+  static constexpr std::size_t ncounters{64};
+  struct alignas(64) Counters {
+    std::atomic<std::uint64_t> lookups{};
+    std::atomic<std::uint64_t> hits{};
+    std::atomic<std::uint64_t> fallbacks{};
+    std::atomic<std::uint64_t> prefetched{};
+    std::atomic<std::uint64_t> queries{};
+    std::atomic<std::uint64_t> parse_ns{};
+    std::atomic<std::uint64_t> puts{};
+    std::atomic<std::uint64_t> duplicate_puts{};
+    std::array<std::atomic<std::uint64_t>, Statistics::nbuckets> lock_waits{};
+    std::atomic<std::uint64_t> lock_wait_ns{};
+    // Not a statistic: lookups now reading the frozen table.
+    std::atomic<std::size_t> frozen_readers{};
+  };
+
+  struct Shard {
+    mutable std::shared_mutex mutex{};
+    collection_type entries{};
+    std::unordered_map<ParameterSetID, Usage, detail::HashParameterSetID>
+      usage{};
+    std::unordered_set<ParameterSetID, detail::HashParameterSetID> spilled{};
+  };
+
+  // Sorted IDs, and copies of the corresponding entries in the shards
+  // (frozen entries are never evicted).
+  struct FrozenTable {
+    std::vector<ParameterSetID> ids{};
+    std::vector<ParameterSet> psets{};
+
+    std::size_t index(ParameterSetID const& id) const noexcept;
+  };
+
+  // The frozen table as of construction, which freeze() does not
+  // destroy until every FrozenReader that may hold it is gone.
+  class FrozenReader {
+  public:
+    FrozenReader(ParameterSetRegistry const& reg, Counters& counters) noexcept;
+    ~FrozenReader();
+    FrozenReader(FrozenReader const&) = delete;
+    FrozenReader& operator=(FrozenReader const&) = delete;
+
+    FrozenTable const* table() const noexcept { return table_; }
+    ParameterSet const* find(ParameterSetID const& id) const noexcept;
+
+  private:
+    std::atomic<std::size_t>& readers_;
+    FrozenTable const* table_;
+  };
+
+  // A read connection to a DB, with its cached lookup statement.
+  struct Source {
+    sqlite3* db{nullptr};
+    sqlite3_stmt* stmt{nullptr};
+  };
+
+  // Connections with which find_ reads the backing DB and the lazily
+  // imported sources.  Each Reader is used by one thread at a time, so
+  // lookups that miss on different IDs do not wait for each other.
+  struct Reader {
+    Reader() = default;
+    Reader(Reader const&) = delete;
+    Reader& operator=(Reader const&) = delete;
+    ~Reader();
+
+    Source primary{};
+    std::size_t primary_generation{};
+    std::vector<Source> sources{};
+  };
+
   ParameterSetRegistry();
   static ParameterSetRegistry& instance_();
-  const_iterator find_(ParameterSetID const& id);
+  static std::size_t shard_index_(ParameterSetID const& id) noexcept;
+  Shard& shard_(ParameterSetID const& id) noexcept;
+  Counters& counters_() noexcept;
+  template <typename Lock>
+  static Lock lock_(Shard const& shard, Counters& counters);
+  std::optional<ParameterSet> find_(ParameterSetID const& id);
+  std::unique_ptr<Reader> acquire_reader_();
+  void release_reader_(std::unique_ptr<Reader> reader);
+  void sync_reader_(Reader& reader);
+  void prefetch_(Reader& reader,
+                 std::string const& psBlob,
+                 Counters& counters);
+  ParameterSetID insert_(ParameterSetID const& id, ParameterSet const& ps);
+  void track_(Shard& shard,
+              ParameterSetID const& id,
+              ParameterSet const& ps,
+              bool in_db);
+  void touch_(Shard const& shard, ParameterSetID const& id) const noexcept;
+  void evict_();
 
-  sqlite3* primaryDB_;
-  sqlite3_stmt* stmt_{nullptr};
-  collection_type registry_{};
-  static std::recursive_mutex mutex_;
-};
+  std::array<Shard, nshards> shards_{};
+  std::array<Counters, ncounters> thread_counters_{};
+  std::unique_ptr<FrozenTable const> frozen_table_{};
+  std::atomic<FrozenTable const*> frozen_{nullptr};
+  std::atomic<frozen_put_policy> frozen_policy_{frozen_put_policy::overflow};
+  // Serializes freezing and eviction.
+  std::mutex maintenance_mutex_{};
 
-inline bool
-fhicl::ParameterSetRegistry::empty()
-{
-  std::lock_guard sentry{mutex_};
-  return instance_().registry_.empty();
-}
+  std::atomic<bool> tracking_{false};
+  std::atomic<std::size_t> budget_{};
+  std::atomic<std::size_t> resident_bytes_{};
+  std::atomic<std::uint64_t> clock_{};
+  std::atomic<bool> evicting_{false};
 
-inline auto
-fhicl::ParameterSetRegistry::size() -> size_type
-{
-  std::lock_guard sentry{mutex_};
-  return instance_().registry_.size();
-}
+  // The backing DB is an in-memory DB in shared-cache mode (or a file,
+  // after spillTo), so that each Reader may open its own connection to
+  // it; its name is unique to this registry.  db_mutex_ is held
+  // exclusively while the backing DB or the list of sources changes,
+  // and shared while Readers query them.
+  std::shared_mutex db_mutex_{};
+  std::string primary_location_;
+  sqlite3* primaryDB_;
+  std::size_t primary_generation_{1};
+  std::vector<std::string> source_files_{};
+
+  std::mutex pool_mutex_{};
+  std::vector<std::unique_ptr<Reader>> idle_readers_{};
+  // Blobs of nested tables, fetched in bulk along with their parent
+  // and parsed when (if) they are looked up, and their total size.
+  std::unordered_map<ParameterSetID, std::string, detail::HashParameterSetID>
+    prefetched_{};
+  std::atomic<std::size_t> prefetched_bytes_{};
+};
 
 // 1.
 inline auto
-fhicl::ParameterSetRegistry::put(ParameterSet const& ps)
-  -> ParameterSetID const&
+fhicl::ParameterSetRegistry::put(ParameterSet const& ps) -> ParameterSetID
 {
-  std::lock_guard sentry{mutex_};
-  return instance_().registry_.emplace(ps.id(), ps).first->first;
+  // Computing the ID may consult the registry, so it is done before
+  // any lock is taken.
+  return instance_().insert_(ps.id(), ps);
 }
 
 // 2.
@@ -129,7 +339,6 @@ inline auto
 fhicl::ParameterSetRegistry::put(FwdIt b, FwdIt const e) -> std::enable_if_t<
   std::is_same_v<typename std::iterator_traits<FwdIt>::value_type, mapped_type>>
 {
-  // No lock here -- it will be acquired by 3.
   for (; b != e; ++b) {
     (void)put(*b);
   }
@@ -138,62 +347,48 @@ fhicl::ParameterSetRegistry::put(FwdIt b, FwdIt const e) -> std::enable_if_t<
 // 3.
 template <class FwdIt>
 inline auto
-fhicl::ParameterSetRegistry::put(FwdIt const b, FwdIt const e)
-  -> std::enable_if_t<
-    std::is_same_v<typename std::iterator_traits<FwdIt>::value_type,
-                   value_type>>
+fhicl::ParameterSetRegistry::put(FwdIt b, FwdIt const e) -> std::enable_if_t<
+  std::is_same_v<typename std::iterator_traits<FwdIt>::value_type, value_type>>
 {
-  std::lock_guard sentry{mutex_};
-  instance_().registry_.insert(b, e);
+  auto& reg = instance_();
+  for (; b != e; ++b) {
+    (void)reg.insert_(b->first, b->second);
+  }
 }
 
 // 4.
 inline void
 fhicl::ParameterSetRegistry::put(collection_type const& c)
 {
-  // No lock here -- it will be acquired by 3.
   put(c.cbegin(), c.cend());
 }
 
 inline auto
-fhicl::ParameterSetRegistry::get() noexcept -> collection_type const&
-{
-  std::lock_guard sentry{mutex_};
-  return instance_().registry_;
-}
-
-inline auto
-fhicl::ParameterSetRegistry::get(ParameterSetID const& id)
-  -> ParameterSet const&
+fhicl::ParameterSetRegistry::get(ParameterSetID const& id) -> ParameterSet
 {
-  std::lock_guard sentry{mutex_};
-  auto it = instance_().find_(id);
-  if (it == instance_().registry_.cend()) {
+  auto ps = instance_().find_(id);
+  if (!ps) {
     throw exception(error::cant_find, "Can't find ParameterSet")
       << "with ID " << id.to_string() << " in the registry.";
   }
-  return it->second;
+  return *std::move(ps);
 }
 
 inline bool
 fhicl::ParameterSetRegistry::get(ParameterSetID const& id, ParameterSet& ps)
 {
-  std::lock_guard sentry{mutex_};
-  bool result{false};
-  auto it = instance_().find_(id);
-  if (it != instance_().registry_.cend()) {
-    ps = it->second;
-    result = true;
+  auto found = instance_().find_(id);
+  if (!found) {
+    return false;
   }
-  return result;
+  ps = *std::move(found);
+  return true;
 }
 
 inline bool
-fhicl::ParameterSetRegistry::has(ParameterSetID const& id)
+fhicl::ParameterSetRegistry::frozen() noexcept
 {
-  std::lock_guard sentry{mutex_};
-  auto const& reg = instance_().registry_;
-  return reg.find(id) != reg.cend();
+  return instance_().frozen_.load(std::memory_order_acquire) != nullptr;
 }
 
 inline auto
@@ -203,10 +398,38 @@ fhicl::ParameterSetRegistry::instance_() -> ParameterSetRegistry&
   return s_registry;
 }
 
+inline std::size_t
+fhicl::ParameterSetRegistry::shard_index_(ParameterSetID const& id) noexcept
+{
+  // The bucket index within a shard is taken modulo a prime by the
+  // unordered_map, so the high bits of the hash are free to pick the
+  // shard.
+  auto const h = detail::HashParameterSetID{}(id);
+  return h >> (std::numeric_limits<size_t>::digits - shard_bits);
+}
+
+inline auto
+fhicl::ParameterSetRegistry::shard_(ParameterSetID const& id) noexcept
+  -> Shard&
+{
+  return shards_[shard_index_(id)];
+}
+
+namespace fhicl {
+  std::ostream& operator<<(std::ostream&,
+                           ParameterSetRegistry::Statistics const&);
+}
+
 inline size_t
-fhicl::detail::HashParameterSetID::operator()(ParameterSetID const& id) const
+fhicl::detail::HashParameterSetID::operator()(
+  ParameterSetID const& id) const noexcept
 {
-  return hash_(id.to_string());
+  // The bytes of a SHA-1 digest are uniformly distributed, so any
+  // size_t-worth of them is as good a hash as can be had.
+  static_assert(sizeof(size_t) <= cet::sha1::digest_sz);
+  size_t result;
+  std::memcpy(&result, id.id_.data(), sizeof result);
+  return result;
 }
 
 #endif /* fhiclcpp_ParameterSetRegistry_h */
@@ -62,6 +62,11 @@
   provided so that category-agnostic instructions can be executed
   before or after the category-specific ones.
 
+  Whatever the form in which a ParameterSet stores its values, each
+  function is handed a table as its ParameterSetID, a sequence as a
+  ParameterSet::ps_sequence_t (itself holding values in these forms),
+  and an atom as its std::string text.
+
 */
 
 #include <any>
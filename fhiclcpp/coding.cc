@@ -6,23 +6,25 @@
 
 #include "fhiclcpp/coding.h"
 
-#include "cetlib/canonical_number.h"
 #include "cetlib/canonical_string.h"
 #include "fhiclcpp/ParameterSet.h"
 #include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/detail/number_text.h"
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
 
+#include <atomic>
 #include <cstddef>
-#include <cstdlib>
 #include <limits>
 #include <stdexcept>
+#include <typeinfo>
 
 using namespace fhicl;
 using namespace fhicl::detail;
 
-using boost::lexical_cast;
-using boost::numeric_cast;
 using std::any;
 using std::any_cast;
+using kind = TypedAtom::kind;
 
 // ======================================================================
 
@@ -62,9 +64,141 @@ atom_rep(any const& a, std::string& result)
   if (is_sequence(a))
     throw fhicl::exception(type_mismatch, "can't obtain atom from sequence");
 
-  result = any_cast<std::string>(a);
+  auto const* text = atom_text(a);
+  if (text == nullptr)
+    throw std::bad_any_cast{};
+  result = *text;
 }
 
+// The stored atom, if it was recognized as being of kind k when the
+// ParameterSet was filled.
+static TypedAtom const*
+typed_atom(any const& a, kind const k)
+{
+  auto const* atom = any_cast<TypedAtom>(&a);
+  return (atom != nullptr && atom->what() == k) ? atom : nullptr;
+}
+
+// The value of a canonical number, failing as boost::lexical_cast
+// (which this replaces) does.
+static ldbl
+to_ldbl(std::string const& text)
+{
+  ldbl result;
+  if (!number_value(text, result))
+    throw boost::bad_lexical_cast{typeid(std::string), typeid(ldbl)};
+  return result;
+}
+
+// The canonical text of a number held as a plain string, rather than
+// as a TypedAtom; what names the type wanted, for the error message.
+static std::string
+untyped_number(any const& a, char const* what)
+{
+  std::string str;
+  decode(a, str);
+
+  extended_value xval;
+  std::string unparsed;
+  if (!parse_value_string(str, xval, unparsed) || !xval.is_a(NUMBER))
+    throw fhicl::exception(type_mismatch,
+                           std::string{"error in "} + what + " string:\n")
+      << str << "\nat or before:\n"
+      << unparsed;
+  return extended_value::atom_t(xval);
+}
+
+// The value of an integer type Int (std::uintmax_t or std::intmax_t)
+// a number has, as boost::numeric_cast followed by a narrowing check
+// on its long double value used to find it, except that overflow and
+// narrowing are detected exactly.  approx, the nearest double to the
+// number, serves only to tell overflow from narrowing for a number
+// with a fractional part.
+template <typename Int>
+static Int
+to_integer(integer_parts const& parts, double const approx)
+{
+  using boost::numeric::negative_overflow;
+  using boost::numeric::positive_overflow;
+  constexpr bool is_signed = std::numeric_limits<Int>::is_signed;
+  constexpr auto max = static_cast<std::uintmax_t>(
+    std::numeric_limits<Int>::max());
+
+  if (!parts.integral) {
+    if (is_signed ? approx < -0x1p63 : approx <= -1.)
+      throw negative_overflow{};
+    if (approx >= (is_signed ? 0x1p63 : 0x1p64))
+      throw positive_overflow{};
+    throw std::range_error("narrowing conversion");
+  }
+  if (parts.magnitude == 0)
+    return 0;
+  if (parts.negative) {
+    if (!is_signed || !parts.fits || parts.magnitude - 1 > max)
+      throw negative_overflow{};
+    return parts.magnitude - 1 == max ? std::numeric_limits<Int>::min() :
+                                        -static_cast<Int>(parts.magnitude);
+  }
+  if (!parts.fits || parts.magnitude > max)
+    throw positive_overflow{};
+  return static_cast<Int>(parts.magnitude);
+}
+
+template <typename Int>
+static Int
+to_integer(std::string const& text)
+{
+  integer_parts parts;
+  double approx{};
+  bool const exact = integer_value(text, parts) && parts.integral;
+  if (!exact && !number_value(text, approx))
+    throw boost::bad_lexical_cast{typeid(std::string), typeid(Int)};
+  return to_integer<Int>(parts, approx);
+}
+
+template <typename T>
+bool
+fhicl::detail::stored_number(any const& a, T& value) noexcept
+{
+  auto const* atom = typed_atom(a, kind::number);
+  if (atom == nullptr)
+    return false;
+  if constexpr (std::is_floating_point_v<T>) {
+    value = atom->real();
+    return true;
+  } else {
+    auto const& parts = atom->integer();
+    if (!parts.fits)
+      return false;
+    if (parts.magnitude == 0) {
+      value = 0;
+      return true;
+    }
+    if (parts.negative) {
+      if constexpr (std::is_unsigned_v<T>) {
+        return false;
+      } else {
+        constexpr auto max =
+          static_cast<std::uintmax_t>(std::numeric_limits<T>::max());
+        if (parts.magnitude - 1 > max)
+          return false;
+        auto const below = static_cast<std::intmax_t>(parts.magnitude - 1);
+        value = static_cast<T>(-below - 1);
+        return true;
+      }
+    }
+    if (parts.magnitude >
+        static_cast<std::uintmax_t>(std::numeric_limits<T>::max()))
+      return false;
+    value = static_cast<T>(parts.magnitude);
+    return true;
+  }
+}
+
+// Sequences at least this long are decoded in parallel, in chunks of
+// about this size.
+constexpr std::size_t parallel_decode_size{1 << 14};
+
 // ----------------------------------------------------------------------
 
 bool
@@ -79,6 +213,34 @@ fhicl::detail::is_nil(std::any const& val)
   return result;
 }
 
+value_kind
+fhicl::detail::kind_of(any const& val)
+{
+  if (is_table(val))
+    return value_kind::table;
+  if (is_sequence(val))
+    return value_kind::sequence;
+  if (auto const* atom = any_cast<TypedAtom>(&val))
+    return atom->what() == kind::nil ? value_kind::nil : value_kind::atom;
+  return is_nil(val) ? value_kind::nil : value_kind::atom;
+}
+
+std::size_t
+fhicl::detail::sequence_size(std::any const& val)
+{
+  if (auto const* packed = any_cast<PackedSequence>(&val))
+    return packed->size();
+  return any_cast<ps_sequence_t const&>(val).size();
+}
+
+ps_sequence_t
+fhicl::detail::sequence_elements(std::any const& val)
+{
+  if (auto const* packed = any_cast<PackedSequence>(&val))
+    return packed->unpacked();
+  return any_cast<ps_sequence_t>(val);
+}
+
 ps_atom_t // string (with quotes)
 fhicl::detail::encode(std::string const& value)
 {
@@ -124,22 +286,17 @@ fhicl::detail::encode(ParameterSet const& value)
 ps_atom_t // unsigned
 fhicl::detail::encode(std::uintmax_t value)
 {
-  std::string result = lexical_cast<std::string>(value);
-  if (result.size() > 6) {
-    std::size_t sz = result.size() - 1;
-    result.insert(1, ".");
-    result += "e+" + lexical_cast<std::string>(sz);
-  }
-  return result;
+  return integer_text(value);
 }
 
 ps_atom_t // signed
 fhicl::detail::encode(std::intmax_t value)
 {
-  std::string result = encode(std::uintmax_t(std::abs(value)));
-  if (value < 0)
-    result.insert(0, "-");
-  return result;
+  // Negating in unsigned arithmetic is well-defined for the most
+  // negative value, too.
+  auto const magnitude =
+    value < 0 ? 0 - static_cast<std::uintmax_t>(value) : value;
+  return integer_text(magnitude, value < 0);
 }
 
 ps_atom_t // floating-point
@@ -154,9 +311,7 @@ fhicl::detail::encode(ldbl value)
   if (static_cast<ldbl>(chopped) == value)
     return encode(chopped);
 
-  std::string result;
-  cet::canonical_number(lexical_cast<std::string>(value), result);
-  return result;
+  return float_text(value);
 }
 
 // ----------------------------------------------------------------------
@@ -164,6 +319,19 @@ fhicl::detail::encode(ldbl value)
 void // string without delimiting quotes
 fhicl::detail::decode(any const& a, std::string& result)
 {
+  if (auto const* atom = any_cast<TypedAtom>(&a)) {
+    switch (atom->what()) {
+    case kind::nil:
+      throw fhicl::exception(type_mismatch, "can't obtain string from nil");
+    case kind::string:
+      result = atom->unquoted();
+      return;
+    default:
+      result = atom->text();
+      return;
+    }
+  }
+
   atom_rep(a, result);
   if (result == canon_nil())
     throw fhicl::exception(type_mismatch, "can't obtain string from nil");
@@ -187,6 +355,11 @@ fhicl::detail::decode(any const& a, std::nullptr_t& result)
 void // bool
 fhicl::detail::decode(any const& a, bool& result)
 {
+  if (auto const* atom = typed_atom(a, kind::boolean)) {
+    result = atom->boolean();
+    return;
+  }
+
   std::string str;
   decode(a, str);
 
@@ -211,68 +384,51 @@ fhicl::detail::decode(any const& a, ParameterSet& result)
 void // unsigned
 fhicl::detail::decode(any const& a, std::uintmax_t& result)
 {
-  std::string str;
-  decode(a, str);
-
-  extended_value xval;
-  std::string unparsed;
-  if (!parse_value_string(str, xval, unparsed) || !xval.is_a(NUMBER))
-    throw fhicl::exception(type_mismatch, "error in unsigned string:\n")
-      << str << "\nat or before:\n"
-      << unparsed;
-
-  auto const& atom = extended_value::atom_t(xval);
-  ldbl via = lexical_cast<ldbl>(atom);
-  result = numeric_cast<std::uintmax_t>(via);
-  if (via != ldbl(result))
-    throw std::range_error("narrowing conversion");
+  if (auto const* atom = typed_atom(a, kind::number)) {
+    result = to_integer<std::uintmax_t>(atom->integer(), atom->real());
+    return;
+  }
+  result = to_integer<std::uintmax_t>(untyped_number(a, "unsigned"));
 }
 
 void // signed
 fhicl::detail::decode(any const& a, std::intmax_t& result)
 {
-  std::string str;
-  decode(a, str);
+  if (auto const* atom = typed_atom(a, kind::number)) {
+    result = to_integer<std::intmax_t>(atom->integer(), atom->real());
+    return;
+  }
+  result = to_integer<std::intmax_t>(untyped_number(a, "signed"));
+}
 
-  extended_value xval;
-  std::string unparsed;
-  if (!parse_value_string(str, xval, unparsed) || !xval.is_a(NUMBER))
-    throw fhicl::exception(type_mismatch, "error in signed string:\n")
-      << str << "\nat or before:\n"
-      << unparsed;
+void // floating-point
+fhicl::detail::decode(any const& a, double& result)
+{
+  if (auto const* atom = typed_atom(a, kind::number)) {
+    result = atom->real();
+    return;
+  }
+  auto const text = untyped_number(a, "float");
+  if (!number_value(text, result))
+    throw boost::bad_lexical_cast{typeid(std::string), typeid(double)};
+}
 
-  auto const& atom = extended_value::atom_t(xval);
-  ldbl via = lexical_cast<ldbl>(atom);
-  result = numeric_cast<std::intmax_t>(via);
-  if (via != ldbl(result))
-    throw std::range_error("narrowing conversion");
+void // floating-point
+fhicl::detail::decode(any const& a, float& result)
+{
+  double via;
+  decode(a, via);
+  result = via;
 }
 
 void // floating-point
 fhicl::detail::decode(any const& a, ldbl& result)
 {
-  std::string str;
-  decode(a, str);
-
-  extended_value xval;
-  std::string unparsed;
-  if (!parse_value_string(str, xval, unparsed) || !xval.is_a(NUMBER))
-    throw fhicl::exception(type_mismatch, "error in float string:\n")
-      << str << "\nat or before:\n"
-      << unparsed;
-
-  auto const& atom = extended_value::atom_t(xval);
-  if (atom.substr(1) == literal_infinity()) {
-    switch (atom[0]) {
-    case '+':
-      result = +std::numeric_limits<ldbl>::infinity();
-      return;
-    case '-':
-      result = -std::numeric_limits<ldbl>::infinity();
-      return;
-    }
-  } else
-    result = lexical_cast<ldbl>(atom);
+  if (auto const* atom = typed_atom(a, kind::number)) {
+    result = to_ldbl(atom->text());
+    return;
+  }
+  result = to_ldbl(untyped_number(a, "float"));
 }
 
 void // complex
@@ -295,4 +451,60 @@ fhicl::detail::decode(any const& a, std::complex<ldbl>& result)
   result = {real, imag};
 }
 
+// ----------------------------------------------------------------------
+
+template <class T> // bulk sequence
+void
+fhicl::detail::decode_numbers(ps_sequence_t const& seq, T* const out)
+{
+  auto decode_range = [&seq, out](std::size_t const b, std::size_t const e) {
+    for (auto i = b; i != e; ++i) {
+      if (!stored_number(seq[i], out[i]))
+        return false;
+    }
+    return true;
+  };
+
+  bool all_stored{true};
+  if (seq.size() < parallel_decode_size) {
+    all_stored = decode_range(0, seq.size());
+  } else {
+    std::atomic<bool> ok{true};
+    tbb::parallel_for(
+      tbb::blocked_range<std::size_t>{0, seq.size(), parallel_decode_size},
+      [&decode_range, &ok](auto const& range) {
+        if (ok.load(std::memory_order_relaxed) &&
+            !decode_range(range.begin(), range.end()))
+          ok.store(false, std::memory_order_relaxed);
+      });
+    all_stored = ok.load();
+  }
+  if (all_stored)
+    return;
+
+  for (std::size_t i = 0; i != seq.size(); ++i)
+    decode(seq[i], out[i]);
+}
+
+template void fhicl::detail::decode_numbers(ps_sequence_t const&, int*);
+template void fhicl::detail::decode_numbers(ps_sequence_t const&, unsigned*);
+template void fhicl::detail::decode_numbers(ps_sequence_t const&, long*);
+template void fhicl::detail::decode_numbers(ps_sequence_t const&,
+                                            unsigned long*);
+template void fhicl::detail::decode_numbers(ps_sequence_t const&, long long*);
+template void fhicl::detail::decode_numbers(ps_sequence_t const&,
+                                            unsigned long long*);
+template void fhicl::detail::decode_numbers(ps_sequence_t const&, float*);
+template void fhicl::detail::decode_numbers(ps_sequence_t const&, double*);
+
+template bool fhicl::detail::stored_number(any const&, int&) noexcept;
+template bool fhicl::detail::stored_number(any const&, unsigned&) noexcept;
+template bool fhicl::detail::stored_number(any const&, long&) noexcept;
+template bool fhicl::detail::stored_number(any const&, unsigned long&) noexcept;
+template bool fhicl::detail::stored_number(any const&, long long&) noexcept;
+template bool fhicl::detail::stored_number(any const&,
+                                           unsigned long long&) noexcept;
+template bool fhicl::detail::stored_number(any const&, float&) noexcept;
+template bool fhicl::detail::stored_number(any const&, double&) noexcept;
+
 // ======================================================================
@@ -23,11 +23,14 @@
 #include "boost/lexical_cast.hpp"
 #include "boost/numeric/conversion/cast.hpp"
 #include "fhiclcpp/ParameterSetID.h"
+#include "fhiclcpp/detail/PackedSequence.h"
+#include "fhiclcpp/detail/TypedAtom.h"
 #include "fhiclcpp/exception.h"
 #include "fhiclcpp/extended_value.h"
 #include "fhiclcpp/fwd.h"
 #include "fhiclcpp/parse.h"
 #include "fhiclcpp/type_traits.h"
+#include "fhiclcpp/value_kind.h"
 
 #include <any>
 #include <array>
@@ -48,9 +51,15 @@ namespace fhicl::detail {
   inline bool
   is_sequence(std::any const& val)
   {
-    return val.type() == typeid(ps_sequence_t);
+    return val.type() == typeid(ps_sequence_t) ||
+           val.type() == typeid(PackedSequence);
   }
 
+  // The number of elements of a sequence, and the elements themselves
+  // (unpacked, for a sequence stored packed).
+  std::size_t sequence_size(std::any const& val);
+  ps_sequence_t sequence_elements(std::any const& val);
+
   inline bool
   is_table(std::any const& val)
   {
@@ -59,6 +68,9 @@ namespace fhicl::detail {
 
   bool is_nil(std::any const& val);
 
+  // What val is, as ParameterSet::kind_of reports it (never absent).
+  value_kind kind_of(std::any const& val);
+
   // ----------------------------------------------------------------------
 
   ps_atom_t encode(std::string const&);       // string (w/ quotes)
@@ -103,7 +115,9 @@ namespace fhicl::detail {
   std::enable_if_t<tt::is_int<T>::value> decode(std::any const&,
                                                 T&); // signed
 
-  void decode(std::any const&, ldbl&); // floating-point
+  void decode(std::any const&, float&);  // floating-point
+  void decode(std::any const&, double&); // floating-point
+  void decode(std::any const&, ldbl&);   // floating-point
 
   template <class T>
   std::enable_if_t<std::is_floating_point_v<T>> decode(std::any const&,
@@ -117,6 +131,30 @@ namespace fhicl::detail {
   template <class T>
   void decode(std::any const&, std::vector<T>&); // sequence
 
+  // Element types whose sequences are decoded in bulk.
+  template <class T>
+  inline constexpr bool is_bulk_decodable_v =
+    std::is_same_v<T, int> || std::is_same_v<T, unsigned> ||
+    std::is_same_v<T, long> || std::is_same_v<T, unsigned long> ||
+    std::is_same_v<T, long long> || std::is_same_v<T, unsigned long long> ||
+    std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+  // Decodes each seq[i] into out[i]; out must have room for
+  // seq.size() values.  Numbers stored by a ParameterSet are converted
+  // in one pass (in parallel for long sequences); should any element
+  // be something else, or out of range, the sequence is decoded
+  // element by element so that the first failure is reported as
+  // decode reports it.  Defined for is_bulk_decodable_v types only.
+  template <class T>
+  void decode_numbers(ps_sequence_t const& seq, T* out);
+
+  // The value as a T of a number stored by a ParameterSet, without
+  // throwing: false if a is not such a number, or if (for an integer
+  // type) the number is out of range or not integral.  Defined for
+  // is_bulk_decodable_v types only.
+  template <class T>
+  bool stored_number(std::any const& a, T& value) noexcept;
+
   template <typename U>
   void decode_tuple(std::any const&, U& tuple); // tuple-type decoding
 
@@ -155,6 +193,15 @@ namespace fhicl::detail {
   tt::disable_if_t<tt::is_numeric<T>::value> decode(std::any const&,
                                                     T&); // none of the above
 
+  // As decode, but reporting failure by returning false.  A value of
+  // the wrong kind for T (a table for a number, an atom for a
+  // ParameterSet, ...) is rejected, and numbers, booleans and
+  // strings stored by a ParameterSet are converted, without an
+  // exception being thrown; anything else is decoded by decode, whose
+  // failure is caught.
+  template <class T>
+  bool try_decode(std::any const& a, T& result);
+
 } // fhicl::detail
 
 // ======================================================================
@@ -235,9 +282,8 @@ template <class T>
 std::enable_if_t<std::is_floating_point_v<T>>
 fhicl::detail::decode(std::any const& a, T& result)
 {
-  ldbl via;
-  decode(a, via);
-  result = via; // boost::numeric_cast<T>(via);
+  // Resolves to the overload for T itself.
+  decode(a, result);
 }
 
 //====================================================================
@@ -258,7 +304,7 @@ template <class T>
 void
 fhicl::detail::decode(std::any const& a, std::vector<T>& result)
 {
-  if (a.type() == typeid(std::string)) {
+  if (atom_text(a) != nullptr) {
     std::string str;
     decode(a, str);
 
@@ -271,6 +317,7 @@ fhicl::detail::decode(std::any const& a, std::vector<T>& result)
 
     auto const& seq = fhicl::extended_value::sequence_t(xval);
     result.clear();
+    result.reserve(seq.size());
     T via;
     for (auto const& e : seq) {
       decode(e.to_string(), via);
@@ -278,13 +325,30 @@ fhicl::detail::decode(std::any const& a, std::vector<T>& result)
     }
   }
 
-  else if (a.type() == typeid(ps_sequence_t)) {
-    ps_sequence_t const& seq = std::any_cast<ps_sequence_t>(a);
-    result.clear();
-    T via;
-    for (auto const& e : seq) {
-      decode(e, via);
-      result.push_back(via);
+  else if (auto const* packed = std::any_cast<PackedSequence>(&a)) {
+    if constexpr (is_bulk_decodable_v<T>) {
+      result.resize(packed->size());
+      if (packed->values(result.data())) {
+        return;
+      }
+    }
+    // Element by element, so that a failure is reported as for any
+    // other sequence.
+    decode(std::any{packed->unpacked()}, result);
+  }
+
+  else if (auto const* seq = std::any_cast<ps_sequence_t>(&a)) {
+    if constexpr (is_bulk_decodable_v<T>) {
+      result.resize(seq->size());
+      decode_numbers(*seq, result.data());
+    } else {
+      result.clear();
+      result.reserve(seq->size());
+      T via;
+      for (auto const& e : *seq) {
+        decode(e, via);
+        result.push_back(via);
+      }
     }
   }
 
@@ -320,7 +384,7 @@ template <typename U>
 void
 fhicl::detail::decode_tuple(std::any const& a, U& result)
 {
-  auto const seq = std::any_cast<ps_sequence_t>(a);
+  auto const seq = sequence_elements(a);
 
   constexpr std::size_t TUPLE_SIZE = std::tuple_size_v<U>;
 
@@ -353,6 +417,112 @@ fhicl::detail::decode(std::any const& a, T& result)
   result = std::any_cast<T>(a);
 }
 
+
+//====================================================================
+// non-throwing decode
+
+namespace fhicl::detail {
+  template <class T>
+  inline constexpr bool is_vector_v = false;
+  template <class T>
+  inline constexpr bool is_vector_v<std::vector<T>> = true;
+
+  template <class T>
+  inline constexpr bool is_tuple_like_v = tt::is_sequence_type<T>::value;
+  template <class KEY, class VALUE>
+  inline constexpr bool is_tuple_like_v<std::pair<KEY, VALUE>> = true;
+
+  // Types that decode from an atom only.
+  template <class T>
+  inline constexpr bool is_atom_type_v =
+    std::is_arithmetic_v<T> || std::is_same_v<T, std::string> ||
+    std::is_same_v<T, std::nullptr_t>;
+  template <class T>
+  inline constexpr bool is_atom_type_v<std::complex<T>> = true;
+
+  template <class T>
+  bool
+  try_decode_elements(ps_sequence_t const& seq, std::vector<T>& result)
+  {
+    result.clear();
+    result.reserve(seq.size());
+    T via;
+    for (auto const& e : seq) {
+      if (!try_decode(e, via)) {
+        return false;
+      }
+      result.push_back(via);
+    }
+    return true;
+  }
+}
+
+template <class T>
+bool
+fhicl::detail::try_decode(std::any const& a, T& result)
+{
+  if constexpr (std::is_same_v<T, ParameterSet>) {
+    if (!is_table(a)) {
+      return false;
+    }
+  } else if constexpr (is_vector_v<T>) {
+    // An atom may hold a sequence as a string; that is left to decode.
+    if (is_table(a)) {
+      return false;
+    }
+    if (auto const* packed = std::any_cast<PackedSequence>(&a)) {
+      if constexpr (is_bulk_decodable_v<typename T::value_type>) {
+        result.resize(packed->size());
+        if (packed->values(result.data())) {
+          return true;
+        }
+      }
+      return try_decode_elements(packed->unpacked(), result);
+    }
+    if (auto const* seq = std::any_cast<ps_sequence_t>(&a)) {
+      return try_decode_elements(*seq, result);
+    }
+  } else if constexpr (is_tuple_like_v<T>) {
+    if (!is_sequence(a)) {
+      return false;
+    }
+  } else if constexpr (is_atom_type_v<T>) {
+    if (is_table(a) || is_sequence(a)) {
+      return false;
+    }
+    if (auto const* atom = std::any_cast<TypedAtom>(&a)) {
+      using kind = TypedAtom::kind;
+      if (std::is_same_v<T, std::nullptr_t> != (atom->what() == kind::nil)) {
+        return false;
+      }
+      if constexpr (std::is_same_v<T, bool>) {
+        if (atom->what() == kind::boolean) {
+          result = atom->boolean();
+          return true;
+        }
+        if (atom->what() == kind::number) {
+          return false;
+        }
+      } else if constexpr (is_bulk_decodable_v<T>) {
+        if (atom->what() == kind::number) {
+          return stored_number(a, result);
+        }
+        if (atom->what() == kind::boolean) {
+          return false;
+        }
+      }
+    }
+  }
+
+  try {
+    decode(a, result);
+    return true;
+  }
+  catch (std::exception const&) {
+    return false;
+  }
+}
+
 // ======================================================================
 
 #endif /* fhiclcpp_coding_h */
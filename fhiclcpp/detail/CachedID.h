@@ -0,0 +1,108 @@
+#ifndef fhiclcpp_detail_CachedID_h
+#define fhiclcpp_detail_CachedID_h
+
+/*
+  ======================================================================
+
+  CachedID
+
+  ======================================================================
+
+  Lazily-computed ParameterSetID owned by a ParameterSet.
+
+  The ID is computed at most once per modification of the owning
+  ParameterSet, even when 'get' is called concurrently from several
+  threads on the same (const) object.  Once the ID has been published,
+  reading it costs a single acquire load.  Threads that arrive while
+  another thread is computing the ID wait for it rather than
+  duplicating the work.
+
+  'invalidate' and assignment may only be called by the owner while it
+  has exclusive access, i.e. from non-const ParameterSet members.
+
+*/
+
+#include "fhiclcpp/ParameterSetID.h"
+
+#include <atomic>
+#include <thread>
+
+namespace fhicl::detail {
+
+  class CachedID {
+  public:
+    CachedID() = default;
+
+    CachedID(CachedID const& other) noexcept { copy_from_(other); }
+
+    CachedID&
+    operator=(CachedID const& other) noexcept
+    {
+      if (this != &other) {
+        copy_from_(other);
+      }
+      return *this;
+    }
+
+    template <typename F>
+    ParameterSetID const& get(F compute) const;
+
+    void
+    invalidate() noexcept
+    {
+      state_.store(invalid, std::memory_order_relaxed);
+    }
+
+  private:
+    enum state_t : unsigned char { invalid, computing, valid };
+
+    void
+    copy_from_(CachedID const& other) noexcept
+    {
+      if (other.state_.load(std::memory_order_acquire) == valid) {
+        id_ = other.id_;
+        state_.store(valid, std::memory_order_relaxed);
+      } else {
+        state_.store(invalid, std::memory_order_relaxed);
+      }
+    }
+
+    mutable std::atomic<state_t> state_{invalid};
+    mutable ParameterSetID id_{};
+  };
+
+  template <typename F>
+  ParameterSetID const&
+  CachedID::get(F compute) const
+  {
+    auto state = state_.load(std::memory_order_acquire);
+    while (state != valid) {
+      if (state == invalid &&
+          state_.compare_exchange_weak(state,
+                                       computing,
+                                       std::memory_order_acquire,
+                                       std::memory_order_acquire)) {
+        try {
+          id_ = compute();
+        }
+        catch (...) {
+          state_.store(invalid, std::memory_order_release);
+          throw;
+        }
+        state_.store(valid, std::memory_order_release);
+        break;
+      }
+      if (state == computing) {
+        std::this_thread::yield();
+        state = state_.load(std::memory_order_acquire);
+      }
+    }
+    return id_;
+  }
+}
+
+#endif /* fhiclcpp_detail_CachedID_h */
+
+// Local Variables:
+// mode: c++
+// End:
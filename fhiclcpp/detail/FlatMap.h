@@ -0,0 +1,212 @@
+#ifndef fhiclcpp_detail_FlatMap_h
+#define fhiclcpp_detail_FlatMap_h
+
+/*
+  ======================================================================
+
+  FlatMap
+
+  ======================================================================
+
+  Associative container holding its elements in a single vector,
+  sorted by key.  Lookups are binary searches over contiguous storage,
+  and copying the container makes one allocation for the elements
+  (plus one per key or value too large to be stored in place).
+
+  Insertion and erasure move the following elements, which is cheap
+  for the table sizes ParameterSet deals with.  Keys arriving in
+  increasing order -- as they do when a table is made from a parsed
+  document -- are appended without any search.
+
+  Unlike std::map, any insertion or erasure invalidates all iterators
+  and references into the container.  Lookups accept any key type
+  comparable with Key through Compare (std::less<> by default).
+
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace fhicl::detail {
+
+  template <typename Key, typename T, typename Compare = std::less<>>
+  class FlatMap {
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<Key, T>;
+    using container_type = std::vector<value_type>;
+    using size_type = typename container_type::size_type;
+    using iterator = typename container_type::iterator;
+    using const_iterator = typename container_type::const_iterator;
+
+    // Observers.
+    bool
+    empty() const noexcept
+    {
+      return elements_.empty();
+    }
+    size_type
+    size() const noexcept
+    {
+      return elements_.size();
+    }
+
+    // Iteration, in key order.
+    iterator
+    begin() noexcept
+    {
+      return elements_.begin();
+    }
+    iterator
+    end() noexcept
+    {
+      return elements_.end();
+    }
+    const_iterator
+    begin() const noexcept
+    {
+      return elements_.begin();
+    }
+    const_iterator
+    end() const noexcept
+    {
+      return elements_.end();
+    }
+    const_iterator
+    cbegin() const noexcept
+    {
+      return elements_.cbegin();
+    }
+    const_iterator
+    cend() const noexcept
+    {
+      return elements_.cend();
+    }
+
+    // Lookup.
+    template <typename K>
+    iterator find(K const& key);
+    template <typename K>
+    const_iterator find(K const& key) const;
+
+    // Modifiers.
+    template <typename V>
+    std::pair<iterator, bool> emplace(Key const& key, V&& value);
+    T& operator[](Key const& key);
+    template <typename K>
+    size_type erase(K const& key);
+    void
+    reserve(size_type const n)
+    {
+      elements_.reserve(n);
+    }
+
+    bool
+    operator==(FlatMap const& other) const
+    {
+      return elements_ == other.elements_;
+    }
+
+  private:
+    template <typename K>
+    const_iterator lower_bound_(K const& key) const;
+    template <typename K>
+    bool
+    matches_(const_iterator const it, K const& key) const
+    {
+      return it != elements_.cend() && !compare_(key, it->first);
+    }
+
+    template <typename A, typename B>
+    static bool
+    compare_(A const& a, B const& b)
+    {
+      return Compare{}(a, b);
+    }
+
+    container_type elements_{};
+  };
+
+  //==========================================================================
+  // Implementation
+
+  template <typename Key, typename T, typename Compare>
+  template <typename K>
+  auto
+  FlatMap<Key, T, Compare>::lower_bound_(K const& key) const -> const_iterator
+  {
+    return std::lower_bound(
+      elements_.cbegin(),
+      elements_.cend(),
+      key,
+      [](value_type const& element, K const& k) {
+        return compare_(element.first, k);
+      });
+  }
+
+  template <typename Key, typename T, typename Compare>
+  template <typename K>
+  auto
+  FlatMap<Key, T, Compare>::find(K const& key) const -> const_iterator
+  {
+    auto const it = lower_bound_(key);
+    return matches_(it, key) ? it : elements_.cend();
+  }
+
+  template <typename Key, typename T, typename Compare>
+  template <typename K>
+  auto
+  FlatMap<Key, T, Compare>::find(K const& key) -> iterator
+  {
+    auto const it = std::as_const(*this).find(key);
+    return elements_.begin() + (it - elements_.cbegin());
+  }
+
+  template <typename Key, typename T, typename Compare>
+  template <typename V>
+  auto
+  FlatMap<Key, T, Compare>::emplace(Key const& key, V&& value)
+    -> std::pair<iterator, bool>
+  {
+    if (elements_.empty() || compare_(elements_.back().first, key)) {
+      elements_.emplace_back(key, std::forward<V>(value));
+      return {elements_.end() - 1, true};
+    }
+    auto const pos = lower_bound_(key);
+    if (matches_(pos, key)) {
+      return {elements_.begin() + (pos - elements_.cbegin()), false};
+    }
+    return {elements_.emplace(pos, key, std::forward<V>(value)), true};
+  }
+
+  template <typename Key, typename T, typename Compare>
+  T&
+  FlatMap<Key, T, Compare>::operator[](Key const& key)
+  {
+    return emplace(key, T{}).first->second;
+  }
+
+  template <typename Key, typename T, typename Compare>
+  template <typename K>
+  auto
+  FlatMap<Key, T, Compare>::erase(K const& key) -> size_type
+  {
+    auto const it = find(key);
+    if (it == elements_.end()) {
+      return 0;
+    }
+    elements_.erase(it);
+    return 1;
+  }
+
+}
+
+#endif /* fhiclcpp_detail_FlatMap_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,213 @@
+// ======================================================================
+//
+// PackedSequence
+//
+// ======================================================================
+
+#include "fhiclcpp/detail/PackedSequence.h"
+
+#include "fhiclcpp/coding.h"
+#include "fhiclcpp/detail/number_text.h"
+
+#include <cmath>
+
+using fhicl::detail::PackedSequence;
+using kind = fhicl::detail::TypedAtom::kind;
+
+namespace {
+
+  std::uintmax_t
+  magnitude(std::intmax_t const value)
+  {
+    return value < 0 ? 0 - static_cast<std::uintmax_t>(value) :
+                       static_cast<std::uintmax_t>(value);
+  }
+
+  // The value of an integral number, if it is in the range of
+  // std::intmax_t.
+  bool
+  integer_of(fhicl::detail::integer_parts const& parts, std::intmax_t& value)
+  {
+    constexpr auto max =
+      static_cast<std::uintmax_t>(std::numeric_limits<std::intmax_t>::max());
+    if (!parts.integral || !parts.fits) {
+      return false;
+    }
+    if (!parts.negative) {
+      if (parts.magnitude > max) {
+        return false;
+      }
+      value = static_cast<std::intmax_t>(parts.magnitude);
+      return true;
+    }
+    if (parts.magnitude == 0) {
+      // "-0" is not what any of the formats makes of 0.
+      return false;
+    }
+    if (parts.magnitude - 1 > max) {
+      return false;
+    }
+    value = -static_cast<std::intmax_t>(parts.magnitude - 1) - 1;
+    return true;
+  }
+
+  // The formats, as bits of a mask, that reproduce text from value.
+  enum : unsigned { first_format = 1u, second_format = 2u };
+
+  unsigned
+  matching_integer_formats(std::string const& text,
+                           std::intmax_t const value,
+                           unsigned const candidates)
+  {
+    unsigned result{};
+    if ((candidates & first_format) && fhicl::detail::encode(value) == text) {
+      result |= first_format;
+    }
+    if ((candidates & second_format) &&
+        fhicl::detail::canonical_integer_text(magnitude(value), value < 0) ==
+          text) {
+      result |= second_format;
+    }
+    return result;
+  }
+
+  unsigned
+  matching_real_formats(std::string const& text,
+                        double const value,
+                        unsigned const candidates)
+  {
+    unsigned result{};
+    if ((candidates & first_format) &&
+        fhicl::detail::encode(static_cast<fhicl::detail::ldbl>(value)) ==
+          text) {
+      result |= first_format;
+    }
+    if ((candidates & second_format) &&
+        fhicl::detail::shortest_text(value) == text) {
+      result |= second_format;
+    }
+    return result;
+  }
+}
+
+PackedSequence::PackedSequence(
+  format const f,
+  std::shared_ptr<std::vector<std::intmax_t> const> integers,
+  std::shared_ptr<std::vector<double> const> reals)
+  : format_{f}, integers_{std::move(integers)}, reals_{std::move(reals)}
+{}
+
+std::optional<PackedSequence>
+PackedSequence::pack(std::vector<std::any> const& elements)
+{
+  if (elements.empty()) {
+    return std::nullopt;
+  }
+
+  std::vector<TypedAtom const*> atoms;
+  atoms.reserve(elements.size());
+  bool all_integers{true};
+  for (auto const& element : elements) {
+    auto const* atom = std::any_cast<TypedAtom>(&element);
+    if (atom == nullptr || atom->what() != kind::number ||
+        !std::isfinite(atom->real())) {
+      return std::nullopt;
+    }
+    std::intmax_t ignored;
+    all_integers = all_integers && integer_of(atom->integer(), ignored);
+    atoms.push_back(atom);
+  }
+
+  unsigned formats{first_format | second_format};
+  if (all_integers) {
+    auto integers = std::make_shared<std::vector<std::intmax_t>>();
+    integers->reserve(atoms.size());
+    for (auto const* atom : atoms) {
+      std::intmax_t value{};
+      integer_of(atom->integer(), value);
+      formats = matching_integer_formats(atom->text(), value, formats);
+      if (formats == 0) {
+        break;
+      }
+      integers->push_back(value);
+    }
+    if (formats != 0) {
+      return PackedSequence{(formats & first_format) ?
+                              format::encoded_integer :
+                              format::canonical_integer,
+                            std::move(integers),
+                            nullptr};
+    }
+  }
+
+  // Integers that no integer format reproduces (too large, or in a
+  // form such as 1.5e1) may still be reproduced as doubles.
+  formats = first_format | second_format;
+  auto reals = std::make_shared<std::vector<double>>();
+  reals->reserve(atoms.size());
+  for (auto const* atom : atoms) {
+    formats = matching_real_formats(atom->text(), atom->real(), formats);
+    if (formats == 0) {
+      return std::nullopt;
+    }
+    reals->push_back(atom->real());
+  }
+  return PackedSequence{(formats & first_format) ? format::encoded_real :
+                                                   format::shortest_real,
+                        nullptr,
+                        std::move(reals)};
+}
+
+std::size_t
+PackedSequence::size() const noexcept
+{
+  return reals_ ? reals_->size() : integers_->size();
+}
+
+std::string
+PackedSequence::text(std::size_t const i) const
+{
+  switch (format_) {
+  case format::encoded_integer:
+    return encode((*integers_)[i]);
+  case format::canonical_integer: {
+    auto const value = (*integers_)[i];
+    return canonical_integer_text(magnitude(value), value < 0);
+  }
+  case format::encoded_real:
+    return encode(static_cast<ldbl>((*reals_)[i]));
+  case format::shortest_real:
+    return shortest_text((*reals_)[i]);
+  }
+  return {};
+}
+
+fhicl::detail::TypedAtom
+PackedSequence::atom(std::size_t const i) const
+{
+  return TypedAtom{text(i)};
+}
+
+std::vector<std::any>
+PackedSequence::unpacked() const
+{
+  std::vector<std::any> result;
+  result.reserve(size());
+  for (std::size_t i = 0, n = size(); i != n; ++i) {
+    result.emplace_back(atom(i));
+  }
+  return result;
+}
+
+std::size_t
+PackedSequence::footprint() const noexcept
+{
+  std::size_t result{sizeof(PackedSequence)};
+  if (reals_) {
+    result += sizeof(*reals_) + reals_->capacity() * sizeof(double);
+  } else {
+    result += sizeof(*integers_) +
+              integers_->capacity() * sizeof(std::intmax_t);
+  }
+  return result;
+}
@@ -0,0 +1,153 @@
+#ifndef fhiclcpp_detail_PackedSequence_h
+#define fhiclcpp_detail_PackedSequence_h
+
+/*
+  ======================================================================
+
+  PackedSequence
+
+  ======================================================================
+
+  The stored form of a sequence of numbers in a ParameterSet, when its
+  values can stand in for its elements: the values are held in one
+  contiguous array (of std::intmax_t if they are all integers in range,
+  of double otherwise), and the canonical text of each element is made
+  again from its value when it is needed.
+
+  A sequence is packed only if one formatting rule reproduces the
+  stored text of every one of its elements, so that printing, and
+  hence every ParameterSetID, is unaffected.  The rules are those of
+  encode(...) for integers and for floating-point values, and those of
+  the parser for integers and for the shortest decimal form of a
+  double.  Any other sequence -- mixed, nested, non-numeric, or with
+  digits beyond the precision of a double -- is stored as a
+  ps_sequence_t of TypedAtoms, as before.
+
+  The values are shared between copies.
+
+*/
+
+#include "fhiclcpp/detail/TypedAtom.h"
+#include "fhiclcpp/sequence_view.h"
+
+#include <any>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace fhicl::detail {
+
+  class PackedSequence {
+  public:
+    // The packed form of a sequence of TypedAtoms, if it has one.
+    static std::optional<PackedSequence> pack(
+      std::vector<std::any> const& elements);
+
+    std::size_t size() const noexcept;
+
+    // The stored text of element i, and that element as a TypedAtom.
+    std::string text(std::size_t i) const;
+    TypedAtom atom(std::size_t i) const;
+
+    // The elements as they would be stored unpacked.
+    std::vector<std::any> unpacked() const;
+
+    // Writes the value of each element, converted to T as decode
+    // converts it, to out, which must have room for size() values.
+    // Returns false if that conversion would fail (or, for an integer
+    // T and floating-point values, might), in which case the contents
+    // of out are unspecified.
+    template <class T>
+    bool values(T* out) const noexcept;
+
+    // A view of the values, if they are held as Ts.
+    template <class T>
+    std::optional<sequence_view<T>> view() const;
+
+    // Heap and object size.
+    std::size_t footprint() const noexcept;
+
+  private:
+    enum class format : unsigned char {
+      encoded_integer,
+      canonical_integer,
+      encoded_real,
+      shortest_real
+    };
+
+    PackedSequence(format f,
+                   std::shared_ptr<std::vector<std::intmax_t> const> integers,
+                   std::shared_ptr<std::vector<double> const> reals);
+
+    format format_;
+    std::shared_ptr<std::vector<std::intmax_t> const> integers_;
+    std::shared_ptr<std::vector<double> const> reals_;
+  };
+
+  // ----------------------------------------------------------------------
+
+  template <class T>
+  bool
+  PackedSequence::values(T* out) const noexcept
+  {
+    static_assert(std::is_arithmetic_v<T>);
+    if (reals_) {
+      if constexpr (std::is_floating_point_v<T>) {
+        for (auto const value : *reals_) {
+          *out++ = static_cast<T>(value);
+        }
+        return true;
+      } else {
+        return false;
+      }
+    }
+    for (auto const value : *integers_) {
+      if constexpr (std::is_floating_point_v<T>) {
+        // As for decode, via the nearest double.
+        *out++ = static_cast<T>(static_cast<double>(value));
+      } else {
+        if constexpr (std::is_unsigned_v<T>) {
+          if (value < 0 ||
+              static_cast<std::uintmax_t>(value) >
+                std::numeric_limits<T>::max()) {
+            return false;
+          }
+        } else {
+          if (value < std::numeric_limits<T>::min() ||
+              value > std::numeric_limits<T>::max()) {
+            return false;
+          }
+        }
+        *out++ = static_cast<T>(value);
+      }
+    }
+    return true;
+  }
+
+  template <class T>
+  std::optional<sequence_view<T>>
+  PackedSequence::view() const
+  {
+    if constexpr (std::is_same_v<T, double>) {
+      if (reals_) {
+        return sequence_view<T>{reals_};
+      }
+    } else if constexpr (std::is_same_v<T, std::intmax_t>) {
+      if (integers_) {
+        return sequence_view<T>{integers_};
+      }
+    }
+    return std::nullopt;
+  }
+}
+
+#endif /* fhiclcpp_detail_PackedSequence_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -3,53 +3,36 @@
 
 #include <any>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace fhicl::detail {
 
   //===============================================================
-  // get_names
+  // is_local_key
 
-  class Keys {
-  public:
-    Keys(std::vector<std::string> const& keys, std::string const& last);
-    ~Keys();
+  // Whether key is a name alone, with no nested table or sequence
+  // index in it, and so can be looked up as it is.
+  inline bool
+  is_local_key(std::string_view const key) noexcept
+  {
+    return !key.empty() && key.find_first_of(".[") == std::string_view::npos;
+  }
 
-    std::vector<std::string> const& tables() const noexcept;
-    std::string const& last() const noexcept;
-
-  private:
-    std::vector<std::string> tables_;
-    std::string last_;
-  };
-
-  Keys get_names(std::string const& key);
+  // The key of the element of name at indices: "name[0][5][1]".
+  std::string indexed_key(std::string_view name,
+                          std::vector<std::size_t> const& indices);
 
   //===============================================================
-  // get_sequence_indices
-
-  class SequenceKey {
-  public:
-    SequenceKey(std::string const& name,
-                std::vector<std::size_t> const& indices);
-    ~SequenceKey();
-
-    std::string const& name() const noexcept;
-    std::vector<std::size_t> const& indices() const noexcept;
-
-  private:
-    std::string name_;
-    std::vector<std::size_t> indices_;
-  };
-
-  SequenceKey get_sequence_indices(std::string const& key);
-
-  //===============================================================
-  // find_an_any
-
-  bool find_an_any(std::vector<std::size_t>::const_iterator it,
-                   std::vector<std::size_t>::const_iterator const cend,
-                   std::any& a);
+  // any_at
+
+  // The element of a at the given (nested) sequence indices, or
+  // nullptr if there is none; nothing is copied.  An element of a
+  // packed sequence is made in (and returned as) element.
+  std::any const* any_at(std::vector<std::size_t>::const_iterator it,
+                         std::vector<std::size_t>::const_iterator cend,
+                         std::any const& a,
+                         std::any& element);
 }
 
 #endif /* fhiclcpp_detail_ParameterSetImplHelpers_h */
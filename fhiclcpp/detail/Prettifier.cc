@@ -93,7 +93,7 @@ Prettifier::atom(std::string const& key, std::any const& a)
 void
 Prettifier::push_size_(std::any const& a)
 {
-  sequence_sizes_.emplace(std::any_cast<ps_sequence_t>(a).size());
+  sequence_sizes_.emplace(sequence_size(a));
   seq_size_ = sequence_sizes_.top();
 }
 
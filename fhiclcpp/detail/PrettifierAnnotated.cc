@@ -86,7 +86,7 @@ PrettifierAnnotated::atom(std::string const& key, std::any const& a)
 void
 PrettifierAnnotated::push_size_(std::any const& a)
 {
-  sequence_sizes_.emplace(std::any_cast<ps_sequence_t>(a).size());
+  sequence_sizes_.emplace(sequence_size(a));
   curr_size_ = sequence_sizes_.top();
 }
 
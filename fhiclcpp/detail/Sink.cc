@@ -0,0 +1,52 @@
+#include "fhiclcpp/detail/Sink.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace fhicl::detail;
+
+namespace {
+  constexpr std::size_t buffer_capacity{4096};
+}
+
+SHA1Sink::SHA1Sink() { buffer_.reserve(buffer_capacity); }
+
+cet::sha1::digest_t
+SHA1Sink::digest()
+{
+  flush_();
+  return sha_.digest();
+}
+
+void
+SHA1Sink::write(char const* data, std::size_t size)
+{
+  // IDs have always been computed from the C-string form of the
+  // ParameterSet's string representation; bytes following an embedded
+  // null character therefore do not contribute to the digest.
+  if (terminated_) {
+    return;
+  }
+  if (auto const nul = static_cast<char const*>(std::memchr(data, '\0', size))) {
+    size = nul - data;
+    terminated_ = true;
+  }
+  while (size != 0) {
+    auto const n = std::min(size, buffer_capacity - buffer_.size());
+    buffer_.append(data, n);
+    data += n;
+    size -= n;
+    if (buffer_.size() == buffer_capacity) {
+      flush_();
+    }
+  }
+}
+
+void
+SHA1Sink::flush_()
+{
+  if (!buffer_.empty()) {
+    sha_ << buffer_;
+    buffer_.clear();
+  }
+}
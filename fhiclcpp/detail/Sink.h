@@ -0,0 +1,83 @@
+#ifndef fhiclcpp_detail_Sink_h
+#define fhiclcpp_detail_Sink_h
+
+/*
+  ======================================================================
+
+  Sink
+
+  ======================================================================
+
+  Destination for the bytes of a ParameterSet's string form, as
+  produced by 'ParameterSet::to_string_'.  Writing through a Sink
+  allows the same serializer to either build a string (StringSink) or
+  feed an incremental SHA-1 computation (SHA1Sink) without ever
+  materializing the full string.
+
+*/
+
+#include "cetlib/sha1.h"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace fhicl::detail {
+
+  class Sink {
+  public:
+    virtual ~Sink() noexcept = default;
+
+    Sink&
+    operator<<(std::string_view const s)
+    {
+      write(s.data(), s.size());
+      return *this;
+    }
+
+    Sink&
+    operator<<(char const c)
+    {
+      write(&c, 1);
+      return *this;
+    }
+
+  private:
+    virtual void write(char const* data, std::size_t size) = 0;
+  };
+
+  class StringSink : public Sink {
+  public:
+    explicit StringSink(std::string& result) : result_{result} {}
+
+  private:
+    void
+    write(char const* data, std::size_t const size) override
+    {
+      result_.append(data, size);
+    }
+
+    std::string& result_;
+  };
+
+  class SHA1Sink : public Sink {
+  public:
+    SHA1Sink();
+
+    cet::sha1::digest_t digest();
+
+  private:
+    void write(char const* data, std::size_t size) override;
+    void flush_();
+
+    cet::sha1 sha_{};
+    std::string buffer_{};
+    bool terminated_{false};
+  };
+}
+
+#endif /* fhiclcpp_detail_Sink_h */
+
+// Local Variables:
+// mode: c++
+// End:
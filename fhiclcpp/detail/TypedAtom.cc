@@ -0,0 +1,93 @@
+// ======================================================================
+//
+// TypedAtom
+//
+// ======================================================================
+
+#include "fhiclcpp/detail/TypedAtom.h"
+
+#include "cetlib/canonical_number.h"
+#include "cetlib/canonical_string.h"
+#include "fhiclcpp/coding.h"
+
+#include <limits>
+
+using fhicl::detail::TypedAtom;
+
+namespace {
+
+  bool
+  is_infinity(std::string const& text)
+  {
+    auto const unsigned_text =
+      (!text.empty() && (text[0] == '+' || text[0] == '-')) ?
+        text.substr(1) :
+        text;
+    return unsigned_text == "infinity";
+  }
+
+  // Only the forms the value parser reads as decimal numbers are
+  // recognized; anything else is left to it.
+  bool
+  is_decimal(std::string const& text)
+  {
+    return !text.empty() &&
+           text.find_first_not_of("0123456789.-+eE") == std::string::npos;
+  }
+}
+
+TypedAtom::TypedAtom(std::string text) : text_{std::move(text)}
+{
+  if (text_.size() == 9 && text_.find_first_not_of('\0') == std::string::npos) {
+    kind_ = kind::nil;
+  } else if (text_ == "true" || text_ == "false") {
+    kind_ = kind::boolean;
+    boolean_ = text_ == "true";
+  } else if (is_infinity(text_)) {
+    kind_ = kind::number;
+    real_ = text_[0] == '-' ? -std::numeric_limits<double>::infinity() :
+                              std::numeric_limits<double>::infinity();
+  } else if (is_decimal(text_)) {
+    // The values are those which the parser-based decoding yields for
+    // the canonical form.
+    std::string canonical;
+    if (cet::canonical_number(text_, canonical) &&
+        number_value(canonical, real_) &&
+        integer_value(canonical, integer_)) {
+      kind_ = kind::number;
+    }
+  } else if (text_.size() >= 2 && text_.front() == '\"' &&
+             text_.back() == '\"') {
+    kind_ = kind::string;
+    auto const quoted = text_.substr(1, text_.size() - 2);
+    if (auto unescaped = cet::unescape(quoted); unescaped != quoted) {
+      unescaped_ = std::move(unescaped);
+    }
+  }
+}
+
+std::string
+TypedAtom::unquoted() const
+{
+  return unescaped_.empty() ? text_.substr(1, text_.size() - 2) : unescaped_;
+}
+
+std::any
+fhicl::detail::typed(std::any const& a)
+{
+  if (auto const* text = std::any_cast<std::string>(&a)) {
+    return TypedAtom{*text};
+  }
+  if (auto const* seq = std::any_cast<ps_sequence_t>(&a)) {
+    ps_sequence_t result;
+    result.reserve(seq->size());
+    for (auto const& element : *seq) {
+      result.push_back(typed(element));
+    }
+    if (auto packed = PackedSequence::pack(result)) {
+      return *std::move(packed);
+    }
+    return result;
+  }
+  return a;
+}
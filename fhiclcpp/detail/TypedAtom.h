@@ -0,0 +1,109 @@
+#ifndef fhiclcpp_detail_TypedAtom_h
+#define fhiclcpp_detail_TypedAtom_h
+
+/*
+  ======================================================================
+
+  TypedAtom
+
+  ======================================================================
+
+  The stored form of an atom in a ParameterSet: its canonical text,
+  together with what that text was found to be when the atom was
+  stored.  Numbers keep their value as an exact integer (when they
+  are integral and small enough) and as the nearest double, booleans
+  their truth value, and double-quoted strings their unescaped
+  contents (when these differ from the text between the quotes), so
+  that decoding a well-formed atom is a check of the kind followed by
+  a range check, rather than a parse.
+
+  Text that is not recognized keeps kind 'other'; decoding it goes
+  through the general parser, as before.  Complex numbers, and
+  strings whose contents are to be read as another type, are among
+  these.
+
+  ParameterSet stores atoms as TypedAtoms; anything obtained from
+  encode(...) is still a plain std::string.  atom_text(...) yields the
+  text of either.
+
+*/
+
+#include "fhiclcpp/detail/number_text.h"
+
+#include <any>
+#include <string>
+
+namespace fhicl::detail {
+
+  class TypedAtom {
+  public:
+    enum class kind : unsigned char { other, nil, boolean, number, string };
+
+    explicit TypedAtom(std::string text);
+
+    std::string const&
+    text() const noexcept
+    {
+      return text_;
+    }
+
+    kind
+    what() const noexcept
+    {
+      return kind_;
+    }
+
+    // Valid for kind::boolean.
+    bool
+    boolean() const noexcept
+    {
+      return boolean_;
+    }
+
+    // Valid for kind::number.
+    integer_parts const&
+    integer() const noexcept
+    {
+      return integer_;
+    }
+    double
+    real() const noexcept
+    {
+      return real_;
+    }
+
+    // Valid for kind::string.
+    std::string unquoted() const;
+
+  private:
+    std::string text_;
+    kind kind_{kind::other};
+    bool boolean_{false};
+    integer_parts integer_{};
+    double real_{};
+    // Set only when unescaping changes the string.
+    std::string unescaped_{};
+  };
+
+  // Text of an atom held either as a TypedAtom or as a plain string;
+  // nullptr for anything else.
+  inline std::string const*
+  atom_text(std::any const& a) noexcept
+  {
+    if (auto const* atom = std::any_cast<TypedAtom>(&a)) {
+      return &atom->text();
+    }
+    return std::any_cast<std::string>(&a);
+  }
+
+  // A copy of a value to be stored in a ParameterSet, with atoms
+  // (including those in sequences) converted to TypedAtoms, and with
+  // sequences of numbers packed where possible (see PackedSequence).
+  std::any typed(std::any const& a);
+}
+
+#endif /* fhiclcpp_detail_TypedAtom_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,387 @@
+// ======================================================================
+//
+// number_text
+//
+// ======================================================================
+
+#include "fhiclcpp/detail/number_text.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <string_view>
+
+namespace {
+
+  // Digits boost::lexical_cast prints for a long double.
+  constexpr int precision =
+    2 + std::numeric_limits<long double>::digits * 30103L / 100000L;
+
+  // Large enough for a long double printed to the above precision
+  // with %g, sign and exponent included.
+  using buffer_t = std::array<char, 64>;
+
+  std::string_view
+  print(long double const value, buffer_t& buf)
+  {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto const [end, ec] = std::to_chars(buf.data(),
+                                         buf.data() + buf.size(),
+                                         value,
+                                         std::chars_format::general,
+                                         precision);
+    return {buf.data(), static_cast<std::size_t>(end - buf.data())};
+#else
+    auto const n =
+      std::snprintf(buf.data(), buf.size(), "%.*Lg", precision, value);
+    return {buf.data(), static_cast<std::size_t>(n)};
+#endif
+  }
+
+  template <typename T>
+  bool
+  is_infinity(std::string_view text, T& value)
+  {
+    bool const negative = !text.empty() && text[0] == '-';
+    if (!text.empty() && (text[0] == '+' || text[0] == '-')) {
+      text.remove_prefix(1);
+    }
+    if (text != "infinity") {
+      return false;
+    }
+    value = negative ? -std::numeric_limits<T>::infinity() :
+                       std::numeric_limits<T>::infinity();
+    return true;
+  }
+
+  bool
+  is_number_text(std::string const& text)
+  {
+    return !text.empty() &&
+           text.find_first_not_of("0123456789.-+eE") == std::string::npos;
+  }
+
+  // As for boost::lexical_cast, only overflow is out of range;
+  // underflow yields a denormalized value or zero.
+  template <typename T, typename Convert>
+  bool
+  c_value(std::string const& text, T& value, Convert convert)
+  {
+    errno = 0;
+    char* end = nullptr;
+    value = convert(text.c_str(), &end);
+    if (end != text.c_str() + text.size()) {
+      return false;
+    }
+    return errno != ERANGE ||
+           std::fabs(value) != std::numeric_limits<T>::infinity();
+  }
+
+  template <typename T, typename Convert>
+  bool
+  value_of(std::string const& text, T& value, [[maybe_unused]] Convert convert)
+  {
+    if (is_infinity(text, value)) {
+      return true;
+    }
+    if (!is_number_text(text)) {
+      return false;
+    }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    // from_chars takes no leading '+'.
+    auto const first = text.data() + (text[0] == '+');
+    if (first != text.data() && text.size() > 1 &&
+        (text[1] == '+' || text[1] == '-')) {
+      return false;
+    }
+    auto const last = text.data() + text.size();
+    auto const [ptr, ec] = std::from_chars(first, last, value);
+    if (ec != std::errc::result_out_of_range) {
+      return ec == std::errc{} && ptr == last;
+    }
+#endif
+    return c_value(text, value, convert);
+  }
+
+  // The canonical form of a finite number printed in decimal or
+  // scientific notation.
+  std::string
+  canonical(std::string_view const printed)
+  {
+    // Split the printed value into its sign, significant digits and the
+    // exponent of the last of these, as cet::canonical_number does.
+    std::size_t i = 0;
+    bool const negative = printed[0] == '-';
+    if (negative) {
+      ++i;
+    }
+    buffer_t digits;
+    std::size_t ndigits = 0;
+    long exp = 0;
+    bool fraction = false;
+    for (; i != printed.size() && printed[i] != 'e'; ++i) {
+      if (printed[i] == '.') {
+        fraction = true;
+        continue;
+      }
+      digits[ndigits++] = printed[i];
+      if (fraction) {
+        --exp;
+      }
+    }
+    if (i != printed.size()) {
+      ++i;
+      if (printed[i] == '+') {
+        ++i;
+      }
+      long printed_exp = 0;
+      std::from_chars(
+        printed.data() + i, printed.data() + printed.size(), printed_exp);
+      exp += printed_exp;
+    }
+
+    std::size_t first = 0;
+    while (first != ndigits && digits[first] == '0') {
+      ++first;
+    }
+    if (first == ndigits) {
+      return "0";
+    }
+    while (digits[ndigits - 1] == '0') {
+      --ndigits;
+      ++exp;
+    }
+    std::string_view const significant{digits.data() + first, ndigits - first};
+    long const nsig = significant.size();
+
+    std::string result;
+    if (exp >= 0 && nsig + exp <= 6) {
+      result.reserve(negative + nsig + exp);
+      if (negative) {
+        result += '-';
+      }
+      result.append(significant).append(exp, '0');
+      return result;
+    }
+
+    // Exponent of the first digit, printed only if non-zero.
+    long const first_exp = exp + nsig - 1;
+    std::array<char, 8> exponent;
+    std::size_t nexp = 0;
+    if (first_exp != 0) {
+      nexp = std::to_chars(
+               exponent.data(), exponent.data() + exponent.size(), first_exp)
+               .ptr -
+             exponent.data();
+    }
+
+    result.reserve(negative + nsig + 2 + nexp);
+    if (negative) {
+      result += '-';
+    }
+    result += significant[0];
+    if (nsig > 1) {
+      result += '.';
+      result.append(significant.substr(1));
+    }
+    if (nexp != 0) {
+      result += 'e';
+      result.append(exponent.data(), nexp);
+    }
+    return result;
+  }
+}
+
+std::string
+fhicl::detail::integer_text(std::uintmax_t const magnitude,
+                            bool const negative)
+{
+  std::array<char, std::numeric_limits<std::uintmax_t>::digits10 + 1> digits;
+  auto const end =
+    std::to_chars(digits.data(), digits.data() + digits.size(), magnitude).ptr;
+  std::size_t const ndigits = end - digits.data();
+
+  std::string result;
+  if (ndigits <= 6) {
+    result.reserve(negative + ndigits);
+    if (negative) {
+      result += '-';
+    }
+    result.append(digits.data(), ndigits);
+    return result;
+  }
+
+  std::array<char, 4> exponent;
+  auto const exp_end =
+    std::to_chars(
+      exponent.data(), exponent.data() + exponent.size(), ndigits - 1)
+      .ptr;
+  std::size_t const nexp = exp_end - exponent.data();
+
+  result.reserve(negative + ndigits + 3 + nexp);
+  if (negative) {
+    result += '-';
+  }
+  result += digits[0];
+  result += '.';
+  result.append(digits.data() + 1, ndigits - 1);
+  result += "e+";
+  result.append(exponent.data(), nexp);
+  return result;
+}
+
+std::string
+fhicl::detail::float_text(long double const value)
+{
+  // Not a number; cet::canonical_number rejects the printed text.
+  if (!std::isfinite(value)) {
+    return {};
+  }
+
+  buffer_t buf;
+  return canonical(print(value, buf));
+}
+
+std::string
+fhicl::detail::canonical_integer_text(std::uintmax_t const magnitude,
+                                      bool const negative)
+{
+  std::array<char, std::numeric_limits<std::uintmax_t>::digits10 + 2> buf;
+  auto first = buf.data();
+  if (negative) {
+    *first++ = '-';
+  }
+  auto const end =
+    std::to_chars(first, buf.data() + buf.size(), magnitude).ptr;
+  return canonical({buf.data(), static_cast<std::size_t>(end - buf.data())});
+}
+
+std::string
+fhicl::detail::shortest_text(double const value)
+{
+  if (!std::isfinite(value)) {
+    return {};
+  }
+
+  buffer_t buf;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  auto const end =
+    std::to_chars(buf.data(), buf.data() + buf.size(), value).ptr;
+  return canonical({buf.data(), static_cast<std::size_t>(end - buf.data())});
+#else
+  for (int digits = 1;; ++digits) {
+    auto const n =
+      std::snprintf(buf.data(), buf.size(), "%.*g", digits, value);
+    if (digits == std::numeric_limits<double>::max_digits10 ||
+        std::strtod(buf.data(), nullptr) == value) {
+      return canonical({buf.data(), static_cast<std::size_t>(n)});
+    }
+  }
+#endif
+}
+
+bool
+fhicl::detail::number_value(std::string const& text, long double& value)
+{
+  return value_of(text, value, [](char const* str, char** end) {
+    return std::strtold(str, end);
+  });
+}
+
+bool
+fhicl::detail::number_value(std::string const& text, double& value)
+{
+  return value_of(text, value, [](char const* str, char** end) {
+    return std::strtod(str, end);
+  });
+}
+
+bool
+fhicl::detail::integer_value(std::string const& text, integer_parts& parts)
+{
+  if (!is_number_text(text)) {
+    return false;
+  }
+  parts = integer_parts{};
+
+  std::size_t i = 0;
+  if (text[0] == '+' || text[0] == '-') {
+    parts.negative = text[0] == '-';
+    ++i;
+  }
+  auto const mantissa_end = text.find_first_of("eE", i);
+  auto const point = text.find('.', i);
+  auto const whole_end = std::min(point, mantissa_end);
+
+  // Exponent, limited to a range beyond which no digit can matter.
+  long exp = 0;
+  if (mantissa_end != std::string::npos) {
+    auto const first = text.data() + mantissa_end + 1;
+    auto const last = text.data() + text.size();
+    auto const exp_first = first + (first != last && *first == '+');
+    auto const [ptr, ec] = std::from_chars(exp_first, last, exp);
+    if (ptr != last || ptr == exp_first) {
+      return false;
+    }
+    if (ec == std::errc::result_out_of_range) {
+      exp = *exp_first == '-' ? -100000 : 100000;
+    }
+  }
+
+  // The digits before the point, then those after it; the k-th of
+  // these (from zero) has the place value 10^(whole.size() - 1 - k + exp).
+  auto const all = std::string_view{text};
+  auto const whole = all.substr(i, std::min(whole_end, text.size()) - i);
+  auto const fraction =
+    point < mantissa_end ?
+      all.substr(point + 1, std::min(mantissa_end, text.size()) - point - 1) :
+      std::string_view{};
+  auto const is_digits = [](std::string_view const s) {
+    return s.find_first_not_of("0123456789") == std::string_view::npos;
+  };
+  if ((whole.empty() && fraction.empty()) || !is_digits(whole) ||
+      !is_digits(fraction)) {
+    return false;
+  }
+  long const ndigits = whole.size() + fraction.size();
+  auto const digit = [&whole, &fraction, ndigits](long const k) -> unsigned {
+    if (k >= ndigits) {
+      return 0;
+    }
+    std::size_t const uk = k;
+    return (uk < whole.size() ? whole[uk] : fraction[uk - whole.size()]) - '0';
+  };
+
+  // Digits with place value 10^0 or more form the integral part.
+  long const nintegral = std::max(0L, static_cast<long>(whole.size()) + exp);
+  parts.integral = true;
+  for (long k = nintegral; k < ndigits; ++k) {
+    if (digit(k) != 0) {
+      parts.integral = false;
+      return true;
+    }
+  }
+
+  constexpr auto max = std::numeric_limits<std::uintmax_t>::max();
+  parts.fits = true;
+  for (long k = 0; k < nintegral; ++k) {
+    if (k >= ndigits && parts.magnitude == 0) {
+      // Zero, however many places it is shifted by.
+      break;
+    }
+    auto const d = digit(k);
+    if (parts.magnitude > (max - d) / 10) {
+      parts.fits = false;
+      parts.magnitude = 0;
+      return true;
+    }
+    parts.magnitude = parts.magnitude * 10 + d;
+  }
+  return true;
+}
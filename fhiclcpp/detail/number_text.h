@@ -0,0 +1,68 @@
+#ifndef fhiclcpp_detail_number_text_h
+#define fhiclcpp_detail_number_text_h
+
+/*
+  ======================================================================
+
+  number_text
+
+  ======================================================================
+
+  Conversions between numbers and the text FHiCL stores for them,
+  formatted into and read from stack buffers so that the only
+  allocation made is that of a resulting string.
+
+  integer_text(...) produces the text encode(...) has always produced
+  for integers: the plain digits if there are at most six of them, and
+  otherwise d.ddd...e+N, with every digit kept.
+
+  float_text(...) produces the canonical number (see
+  cet::canonical_number) of a floating-point value printed to the
+  precision boost::lexical_cast uses, which is what encode(...) has
+  always stored for non-integral values.  std::to_chars is used when
+  the standard library provides it for floating-point types, and
+  snprintf otherwise; the two produce the same characters.
+
+  canonical_integer_text(...) is instead the canonical form of the
+  integer as the parser makes it from its digits (1.234567e6, rather
+  than 1.234567e+6), and shortest_text(...) that of the shortest
+  decimal text that reads back as the given double.
+
+  number_value(...) reads what boost::lexical_cast<long double> would,
+  for text of the form of a canonical number or of an infinity.  It
+  returns false for anything else, and for values out of range.  The
+  double overload yields the double nearest the text, without going
+  through long double.
+
+  integer_value(...) reads the same text as an exact integer: whether
+  it has a fractional part is decided from the digits, not from a
+  rounded value, and the magnitude is kept if it fits in uintmax_t.
+
+*/
+
+#include <cstdint>
+#include <string>
+
+namespace fhicl::detail {
+  struct integer_parts {
+    std::uintmax_t magnitude{};
+    bool negative{false};
+    bool integral{false}; // no non-zero digit after the point
+    bool fits{false};     // integral, and magnitude holds the value
+  };
+
+  std::string integer_text(std::uintmax_t magnitude, bool negative = false);
+  std::string float_text(long double value);
+  std::string canonical_integer_text(std::uintmax_t magnitude,
+                                     bool negative = false);
+  std::string shortest_text(double value);
+  bool number_value(std::string const& text, long double& value);
+  bool number_value(std::string const& text, double& value);
+  bool integer_value(std::string const& text, integer_parts& parts);
+}
+
+#endif /* fhiclcpp_detail_number_text_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,226 @@
+// ======================================================================
+//
+// parse_atom
+//
+// Each recognizer below accepts exactly what the corresponding token
+// parser of the value grammar (see tokens.h and parse.cc) accepts when
+// that token spans the whole input, and the recognizers are tried in
+// the order of the grammar's alternatives.  Since every accepted
+// token is free of the characters at which an earlier alternative
+// could stop short, no earlier alternative can match a prefix of it.
+//
+// ======================================================================
+
+#include "fhiclcpp/detail/parse_atom.h"
+
+#include "cetlib/canonical_number.h"
+#include "cetlib/canonical_string.h"
+#include "fhiclcpp/extended_value.h"
+
+#include <algorithm>
+#include <cctype>
+#include <optional>
+
+namespace {
+
+  using fhicl::extended_value;
+  using opt_string = std::optional<std::string>;
+
+  bool
+  is_space(char const ch)
+  {
+    return std::isspace(static_cast<unsigned char>(ch));
+  }
+
+  bool
+  is_digit(char const ch)
+  {
+    return ch >= '0' && ch <= '9';
+  }
+
+  bool
+  is_word(char const ch)
+  {
+    return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_';
+  }
+
+  template <typename Pred>
+  bool
+  all_of(std::string_view const s, Pred pred)
+  {
+    return std::all_of(s.begin(), s.end(), pred);
+  }
+
+  std::string_view
+  trimmed(std::string_view s)
+  {
+    while (!s.empty() && is_space(s.front())) {
+      s.remove_prefix(1);
+    }
+    while (!s.empty() && is_space(s.back())) {
+      s.remove_suffix(1);
+    }
+    return s;
+  }
+
+  opt_string
+  canonical_number(std::string_view const s)
+  {
+    std::string result;
+    if (!cet::canonical_number(std::string{s}, result)) {
+      return std::nullopt;
+    }
+    return result;
+  }
+
+  // Unsigned integer, decimal, infinity, hexadecimal or binary number.
+  // An empty result means either that the token is not a number, or
+  // that the grammar would reject it (which it signals by throwing).
+  opt_string
+  number(std::string_view const t)
+  {
+    if (t.empty()) {
+      return std::nullopt;
+    }
+    if (all_of(t, is_digit)) {
+      // The grammar throws if this fails; leave that to it.
+      auto const nzeros = std::min(t.find_first_not_of('0'), t.size() - 1);
+      return canonical_number(t.substr(nzeros));
+    }
+    auto const unsigned_t =
+      (t[0] == '+' || t[0] == '-') ? t.substr(1) : t;
+    if (unsigned_t == "infinity") {
+      return t[0] == 'i' ? '+' + std::string{t} : std::string{t};
+    }
+    if (t.find_first_not_of("0123456789.-+eE") == std::string_view::npos) {
+      return canonical_number(t);
+    }
+    if (t.size() > 2 && t[0] == '0') {
+      auto const base = std::toupper(static_cast<unsigned char>(t[1]));
+      auto const digits = t.substr(2);
+      if ((base == 'X' && all_of(digits, [](char const ch) {
+             return std::isxdigit(static_cast<unsigned char>(ch));
+           })) ||
+          (base == 'B' && digits.find_first_not_of("01") ==
+                            std::string_view::npos)) {
+        return canonical_number(t);
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Whether t is a single-quoted (no escapes) or double-quoted (\"
+  // escapes only) string ending at its closing quote.
+  bool
+  quoted(std::string_view const t)
+  {
+    if (t.size() < 2) {
+      return false;
+    }
+    if (t[0] == '\'') {
+      return t.find('\'', 1) == t.size() - 1;
+    }
+    if (t[0] != '\"') {
+      return false;
+    }
+    std::size_t i = 1;
+    while (i != t.size() && t[i] != '\"') {
+      i += (t[i] == '\\' && i + 1 != t.size() && t[i + 1] == '\"') ? 2 : 1;
+    }
+    return i == t.size() - 1;
+  }
+
+  // Unquoted (ass or dss) or quoted string.
+  bool
+  string_token(std::string_view const t)
+  {
+    if (!t.empty() && all_of(t, is_word)) {
+      // A token starting with a digit must have a non-digit in it,
+      // or it would have been read as a number.
+      return !is_digit(t[0]) || !all_of(t, is_digit);
+    }
+    return quoted(t);
+  }
+
+  // The number between '(' and ',', or between ',' and ')'.
+  opt_string
+  complex_part(std::string_view const part)
+  {
+    auto const t = trimmed(part);
+    if (std::any_of(t.begin(), t.end(), is_space)) {
+      return std::nullopt;
+    }
+    return number(t);
+  }
+
+  bool
+  complex(std::string_view const t, extended_value::complex_t& result)
+  {
+    if (t.size() < 5 || t.front() != '(' || t.back() != ')') {
+      return false;
+    }
+    auto const comma = t.find(',');
+    if (comma == std::string_view::npos) {
+      return false;
+    }
+    auto real = complex_part(t.substr(1, comma - 1));
+    if (!real) {
+      return false;
+    }
+    auto imag = complex_part(t.substr(comma + 1, t.size() - comma - 2));
+    if (!imag) {
+      return false;
+    }
+    result = {std::move(*real), std::move(*imag)};
+    return true;
+  }
+}
+
+bool
+fhicl::detail::parse_atom(std::string_view const s, extended_value& result)
+{
+  // Characters outside the basic character set are left to the
+  // grammar.  (A comment cannot be part of an accepted token: outside
+  // quotes, '#' and '/' are accepted by none of the recognizers.)
+  if (std::any_of(s.begin(), s.end(), [](char const ch) {
+        return static_cast<unsigned char>(ch) > 127;
+      })) {
+    return false;
+  }
+
+  auto const t = trimmed(s);
+  if (t.empty()) {
+    return false;
+  }
+
+  if (t == "@nil") {
+    result = extended_value{false, NIL, std::string(9, '\0')};
+    return true;
+  }
+  if (t == "true" || t == "false") {
+    result = extended_value{false, BOOL, std::string{t}};
+    return true;
+  }
+  if (auto num = number(t)) {
+    result = extended_value{false, NUMBER, std::move(*num)};
+    return true;
+  }
+  if (t[0] == '(') {
+    extended_value::complex_t c;
+    if (!complex(t, c)) {
+      return false;
+    }
+    result = extended_value{false, COMPLEX, std::move(c)};
+    return true;
+  }
+  if (string_token(t)) {
+    std::string canonical;
+    // The grammar throws if this fails; leave that to it.
+    if (!cet::canonical_string(std::string{t}, canonical)) {
+      return false;
+    }
+    result = extended_value{false, STRING, std::move(canonical)};
+    return true;
+  }
+  return false;
+}
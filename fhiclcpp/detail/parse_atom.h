@@ -0,0 +1,46 @@
+#ifndef fhiclcpp_detail_parse_atom_h
+#define fhiclcpp_detail_parse_atom_h
+
+/*
+  ======================================================================
+
+  parse_atom
+
+  ======================================================================
+
+  Fast path of parse_value_string for input holding a single atom:
+  @nil, true or false, a number (decimal, infinity, hexadecimal or
+  binary), a complex number, or an unquoted, single- or double-quoted
+  string, optionally surrounded by whitespace.
+
+  The input is classified by scanning it in place, and only an atom
+  that is accepted is canonicalized.  Anything else -- sequences,
+  tables, @id::, comments, malformed atoms, or input for which the
+  answer is not certain -- makes parse_atom return false without
+  touching the result, so that the caller can fall back to the full
+  grammar; whenever parse_atom returns true, its result is that which
+  the grammar produces.
+
+  parse_value_string_grammar is the grammar-based parse alone, for
+  testing the fast path against it.
+
+*/
+
+#include "fhiclcpp/fwd.h"
+
+#include <string>
+#include <string_view>
+
+namespace fhicl::detail {
+  bool parse_atom(std::string_view s, extended_value& result);
+
+  bool parse_value_string_grammar(std::string const& s,
+                                  extended_value& result,
+                                  std::string& unparsed);
+}
+
+#endif /* fhiclcpp_detail_parse_atom_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -1,4 +1,5 @@
 #include "fhiclcpp/detail/printing_helpers.h"
+#include "fhiclcpp/detail/TypedAtom.h"
 #include "fhiclcpp/exception.h"
 
 #include <cassert>
@@ -99,8 +100,7 @@ atom::printed_prefix(std::string const& key)
 std::string
 atom::value(std::any const& a)
 {
-  using ps_atom_t = std::string;
-  std::string const str = std::any_cast<ps_atom_t>(a);
+  auto const& str = *detail::atom_text(a);
   return str == std::string(9, '\0') ? "@nil" : str;
 }
 
@@ -4,25 +4,26 @@
 #include "fhiclcpp/exception.h"
 
 #include <string>
+#include <string_view>
 
 namespace fhicl::detail {
   template <typename L>
   void
-  try_insert(L l, std::string const& key)
+  try_insert(L l, std::string_view const key)
   try {
     l(key);
   }
   catch (boost::bad_lexical_cast const& e) {
-    throw fhicl::exception{cant_insert, key} << e.what();
+    throw fhicl::exception{cant_insert, std::string{key}} << e.what();
   }
   catch (boost::bad_numeric_cast const& e) {
-    throw fhicl::exception{cant_insert, key} << e.what();
+    throw fhicl::exception{cant_insert, std::string{key}} << e.what();
   }
   catch (fhicl::exception const& e) {
-    throw fhicl::exception{cant_insert, key, e};
+    throw fhicl::exception{cant_insert, std::string{key}, e};
   }
   catch (std::exception const& e) {
-    throw fhicl::exception{cant_insert, key} << e.what();
+    throw fhicl::exception{cant_insert, std::string{key}} << e.what();
   }
 }
 
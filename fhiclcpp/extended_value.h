@@ -12,6 +12,7 @@
 #include "fhiclcpp/stdmap_shims.h"
 
 #include <any>
+#include <functional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -39,7 +40,7 @@ public:
   using atom_t = std::string;
   using complex_t = std::pair<std::string, std::string>;
   using sequence_t = std::vector<extended_value>;
-  using table_t = shims::map<std::string, extended_value>;
+  using table_t = shims::map<std::string, extended_value, std::less<>>;
 
   extended_value();
   ~extended_value();
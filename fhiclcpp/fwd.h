@@ -9,6 +9,7 @@
 
 namespace fhicl {
 
+  class Key;
   class ParameterSet;
   class ParameterSetID;
   class ParameterSetWalker;
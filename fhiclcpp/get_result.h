@@ -0,0 +1,94 @@
+#ifndef fhiclcpp_get_result_h
+#define fhiclcpp_get_result_h
+
+/*
+  ======================================================================
+
+  get_result
+
+  ======================================================================
+
+  What ParameterSet::try_get found for a key: its value as a T, if
+  the key names a value that converts to one, and otherwise whether
+  the key is absent or names a value of another type.  kind() tells
+  what the key names in either case.
+
+*/
+
+#include "fhiclcpp/value_kind.h"
+
+#include <optional>
+#include <utility>
+
+namespace fhicl {
+
+  template <class T>
+  class get_result {
+  public:
+    // The key is absent.
+    get_result() = default;
+    // The key names a value of kind k that does not convert to a T.
+    explicit get_result(value_kind const k) noexcept : kind_{k} {}
+    // The key names a value of kind k, which converts to value.
+    get_result(value_kind const k, T value)
+      : kind_{k}, value_{std::move(value)}
+    {}
+
+    value_kind
+    kind() const noexcept
+    {
+      return kind_;
+    }
+    bool
+    absent() const noexcept
+    {
+      return kind_ == value_kind::absent;
+    }
+    bool
+    type_mismatch() const noexcept
+    {
+      return !absent() && !value_;
+    }
+
+    bool
+    has_value() const noexcept
+    {
+      return value_.has_value();
+    }
+    explicit operator bool() const noexcept { return has_value(); }
+
+    // Valid only if has_value().
+    T const&
+    operator*() const& noexcept
+    {
+      return *value_;
+    }
+    T&&
+    operator*() && noexcept
+    {
+      return *std::move(value_);
+    }
+    T const*
+    operator->() const noexcept
+    {
+      return &*value_;
+    }
+
+    template <class U>
+    T
+    value_or(U&& default_value) const&
+    {
+      return value_.value_or(std::forward<U>(default_value));
+    }
+
+  private:
+    value_kind kind_{value_kind::absent};
+    std::optional<T> value_{};
+  };
+}
+
+#endif /* fhiclcpp_get_result_h */
+
+// Local Variables:
+// mode: c++
+// End:
@@ -6,14 +6,15 @@
 
 #include "fhiclcpp/intermediate_table.h"
 
-#include "boost/algorithm/string.hpp"
 #include "fhiclcpp/Protection.h"
 #include "fhiclcpp/exception.h"
 #include "fhiclcpp/parse_shims_opts.h"
 #include "fhiclcpp/stdmap_shims.h"
 
+#include <algorithm>
 #include <cctype>
-#include <cstdlib>
+#include <charconv>
+#include <cstddef>
 #include <utility>
 
 using namespace std::string_literals;
@@ -49,6 +50,56 @@ namespace {
     static extended_value const empty_tbl{false, TABLE, table_t{}};
     return empty_tbl;
   }
+
+  // The parts of a key -- "a", "b", "1" and "" for "a.b[1]" -- as
+  // boost::algorithm::split would make them, but as views into the key.
+  class key_parts {
+  public:
+    explicit key_parts(std::string_view const key) noexcept : key_{key} {}
+
+    // Sets part to the next part, if there is one.
+    bool
+    next(std::string_view& part) noexcept
+    {
+      if (pos_ > key_.size()) {
+        return false;
+      }
+      auto const end =
+        std::min(key_.find_first_of(separators(), pos_), key_.size());
+      part = key_.substr(pos_, end - pos_);
+      pos_ = end + 1;
+      return true;
+    }
+
+  private:
+    static std::string_view
+    separators()
+    {
+      static std::string_view const chars{shims::isSnippetMode() ? "[]" :
+                                                                   ".[]"};
+      return chars;
+    }
+
+    std::string_view key_;
+    std::size_t pos_{};
+  };
+
+  std::string_view
+  first_part(std::string_view const key) noexcept
+  {
+    std::string_view result;
+    key_parts{key}.next(result);
+    return result;
+  }
+
+  // The index in a part such as "12", read as std::atoi would read it.
+  std::size_t
+  index_of(std::string_view const part) noexcept
+  {
+    std::size_t result{};
+    std::from_chars(part.data(), part.data() + part.size(), result);
+    return result;
+  }
 }
 
 // ----------------------------------------------------------------------
@@ -109,28 +160,31 @@ intermediate_table::insert(std::string const& key, extended_value&& value)
 // ----------------------------------------------------------------------
 
 extended_value const&
-intermediate_table::find(std::string const& key) const
+intermediate_table::find(std::string_view const key) const
 {
   extended_value const* p = &ex_val;
-  for (auto const& name : split(key)) {
+  key_parts parts{key};
+  for (std::string_view name; parts.next(name);) {
     if (name.empty()) {
     } else if (std::isdigit(name[0])) {
       if (!p->is_a(SEQUENCE))
-        throw exception(cant_find, key)
+        throw exception(cant_find, std::string{key})
           << "-- not a sequence (at part \"" << name << "\")";
       auto const& s = std::any_cast<sequence_t const&>(p->value);
-      unsigned i = std::atoi(name.c_str());
+      auto const i = index_of(name);
       if (s.size() <= i)
-        throw exception(cant_find, key) << "(at part \"" << name << "\")";
+        throw exception(cant_find, std::string{key})
+          << "(at part \"" << name << "\")";
       p = &s[i];
     } else { /* name[0] is alpha or '_' */
       if (!p->is_a(TABLE))
-        throw exception(cant_find, key)
+        throw exception(cant_find, std::string{key})
           << "-- not a table (at part \"" << name << "\")";
       auto const& t = std::any_cast<table_t const&>(p->value);
       auto it = t.find(name);
       if (it == t.end())
-        throw exception(cant_find, key) << "(at part \"" << name << "\")";
+        throw exception(cant_find, std::string{key})
+          << "(at part \"" << name << "\")";
       p = &it->second;
     }
   } // for
@@ -140,17 +194,18 @@ intermediate_table::find(std::string const& key) const
 // ----------------------------------------------------------------------
 
 bool
-intermediate_table::exists(std::string const& key) const
+intermediate_table::exists(std::string_view const key) const
 {
   extended_value const* p = &ex_val;
-  for (auto const& name : split(key)) {
+  key_parts parts{key};
+  for (std::string_view name; parts.next(name);) {
     if (name.empty()) {
     } else if (std::isdigit(name[0])) {
       if (!p->is_a(SEQUENCE)) {
         return false;
       }
       auto const& s = std::any_cast<sequence_t const&>(p->value);
-      unsigned i = std::atoi(name.c_str());
+      auto const i = index_of(name);
       if (s.size() <= i) {
         return false;
       }
@@ -179,20 +234,21 @@ intermediate_table::erase(std::string const& key, bool const in_prolog)
   auto p(&ex_val);
   auto t(std::any_cast<table_t>(&p->value));
   auto it(t->end());
-  auto const names = split(key);
   if ((!in_prolog) &&
-      (((it = t->find(names[0])) == t->end()) || it->second.in_prolog)) {
+      (((it = t->find(first_part(key))) == t->end()) ||
+       it->second.in_prolog)) {
     return;
   }
   bool at_sequence(false);
-  for (auto const& name : names) {
+  key_parts parts{key};
+  for (std::string_view name; parts.next(name);) {
     if (name.empty()) {
     } else if (std::isdigit(name[0])) {
       if (!p->is_a(SEQUENCE))
-        throw exception(cant_find, name)
+        throw exception(cant_find, std::string{name})
           << "-- not a sequence (at part \"" << name << "\")";
       auto& s = std::any_cast<sequence_t&>(p->value);
-      unsigned i = std::atoi(name.c_str());
+      auto const i = index_of(name);
       if (s.size() <= i) {
         return;
       }
@@ -200,7 +256,7 @@ intermediate_table::erase(std::string const& key, bool const in_prolog)
       at_sequence = true;
     } else { /* name[0] is alpha or '_' */
       if (!p->is_a(TABLE))
-        throw exception(cant_find, name)
+        throw exception(cant_find, std::string{name})
           << "-- not a table (at part \"" << name << "\")";
       at_sequence = false;
       t = std::any_cast<table_t>(&p->value);
@@ -212,7 +268,7 @@ intermediate_table::erase(std::string const& key, bool const in_prolog)
       auto prot = p->protection;
       if (prot == Protection::PROTECT_ERROR) {
         throw exception(protection_violation)
-          << ((name != key) ? (std::string("Part \"") + name +
+          << ((name != key) ? (std::string("Part \"").append(name) +
                                "\" of specification to be erased\n") :
                               "")
           << '"' << name << "\" is protected on " << p->pretty_src_info()
@@ -236,8 +292,7 @@ intermediate_table::pre_insert_(std::string const& key,
 {
   if (!value.in_prolog) {
     auto& t = std::any_cast<table_t&>(ex_val.value);
-    auto const names = split(key);
-    auto it = t.find(names[0]);
+    auto it = t.find(first_part(key));
     if (it != t.end() && it->second.in_prolog) {
       t.erase(it);
     }
@@ -254,22 +309,23 @@ intermediate_table::pre_insert_(std::string const& key,
 }
 
 std::pair<extended_value*, bool>
-intermediate_table::locate_(std::string const& key, bool const in_prolog)
+intermediate_table::locate_(std::string_view const key, bool const in_prolog)
 {
   std::pair<extended_value*, bool> result(nullptr, true);
   extended_value*& p = result.first;
   p = &ex_val;
-  for (auto const& name : split(key)) {
+  key_parts parts{key};
+  for (std::string_view name; parts.next(name);) {
     if (name.empty()) {
     } else if (std::isdigit(name[0])) {
       if (p->is_a(NIL)) {
         *p = empty_seq();
       }
       if (!p->is_a(SEQUENCE))
-        throw exception(cant_find, name)
+        throw exception(cant_find, std::string{name})
           << "-- not a sequence (at part \"" << name << "\")";
       auto& s = std::any_cast<sequence_t&>(p->value);
-      unsigned i = std::atoi(name.c_str());
+      auto const i = index_of(name);
       while (s.size() <= i) {
         s.push_back(nil_item());
       }
@@ -281,19 +337,23 @@ intermediate_table::locate_(std::string const& key, bool const in_prolog)
         p->set_prolog(in_prolog);
       }
       if (!p->is_a(TABLE))
-        throw exception(cant_find, name)
+        throw exception(cant_find, std::string{name})
           << "-- not a table (at part \"" << name << "\")";
       auto& t = std::any_cast<table_t&>(p->value);
-      // This will do what we need whether the key is already in the
-      // map or not.
-      p = &t.emplace(name, nil_item()).first->second;
+      // Only a name not already in the map is copied into it.  (In
+      // snippet mode, every assignment makes an entry of its own.)
+      auto it = shims::isSnippetMode() ? t.end() : t.find(name);
+      if (it == t.end()) {
+        it = t.emplace(std::string{name}, nil_item()).first;
+      }
+      p = &it->second;
       p->set_prolog(in_prolog);
     }
 
     auto prot = p->protection;
     if (prot == Protection::PROTECT_ERROR) {
       throw exception(protection_violation)
-        << ((name != key) ? (std::string("Part \"") + name +
+        << ((name != key) ? (std::string("Part \"").append(name) +
                              "\" of specification to be overwritten\n") :
                             "")
         << '"' << key << "\" is protected on " << p->pretty_src_info() << '\n';
@@ -306,13 +366,4 @@ intermediate_table::locate_(std::string const& key, bool const in_prolog)
   return result;
 } // locate_()
 
-std::vector<std::string>
-intermediate_table::split(std::string const& key)
-{
-  static std::string const splitChars{shims::isSnippetMode() ? "[]" : ".[]"};
-  std::vector<std::string> result;
-  boost::algorithm::split(result, key, boost::algorithm::is_any_of(splitChars));
-  return result;
-}
-
 // ======================================================================
@@ -57,6 +57,7 @@
 #include <any>
 #include <complex>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <vector>
 
@@ -68,7 +69,7 @@ public:
   // Simple interface:
   bool empty() const;
 
-  bool exists(std::string const& key) const;
+  bool exists(std::string_view key) const;
 
   void erase(std::string const& key, bool in_prolog = false);
 
@@ -126,13 +127,13 @@ public:
   bool insert(std::string const& key, extended_value&& value);
 
   /// \throw if item does not exist.
-  extended_value const& find(std::string const& key) const;
+  extended_value const& find(std::string_view key) const;
 
   /// \return nullptr if not able to be updated.
-  extended_value* locate(std::string const& key);
+  extended_value* locate(std::string_view key);
 
   /// \throw if not able to be updated.
-  extended_value& update(std::string const& key);
+  extended_value& update(std::string_view key);
 
 private:
   // Do all the work required to find somewhere to put the new
@@ -141,11 +142,9 @@ private:
                               extended_value const& value);
 
   // Return an item with a bool indicating whether it may be updated.
-  std::pair<extended_value*, bool> locate_(std::string const& key,
+  std::pair<extended_value*, bool> locate_(std::string_view key,
                                            bool in_prolog = false);
 
-  static std::vector<std::string> split(std::string const& key);
-
   extended_value ex_val{false, TABLE, table_t{}};
 
 }; // intermediate_table
@@ -363,7 +362,7 @@ fhicl::intermediate_table::putNil(std::string const& key,
 }
 
 inline fhicl::extended_value*
-fhicl::intermediate_table::locate(std::string const& key)
+fhicl::intermediate_table::locate(std::string_view const key)
 {
   extended_value* result = nullptr;
   auto located = locate_(key);
@@ -374,7 +373,7 @@ fhicl::intermediate_table::locate(std::string const& key)
 }
 
 inline fhicl::extended_value&
-fhicl::intermediate_table::update(std::string const& key)
+fhicl::intermediate_table::update(std::string_view const key)
 {
   auto located = locate_(key);
   if (!located.second) {
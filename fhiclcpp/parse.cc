@@ -18,6 +18,7 @@
 #include "cetlib/include.h"
 #include "cetlib/includer.h"
 #include "fhiclcpp/detail/binding_modifier.h"
+#include "fhiclcpp/detail/parse_atom.h"
 #include "fhiclcpp/exception.h"
 #include "fhiclcpp/extended_value.h"
 #include "fhiclcpp/intermediate_table.h"
@@ -658,6 +659,18 @@ bool
 fhicl::parse_value_string(std::string const& s,
                           extended_value& result,
                           std::string& unparsed)
+{
+  if (detail::parse_atom(s, result)) {
+    unparsed.clear();
+    return true;
+  }
+  return detail::parse_value_string_grammar(s, result, unparsed);
+} // parse_value_string()
+
+bool
+fhicl::detail::parse_value_string_grammar(std::string const& s,
+                                          extended_value& result,
+                                          std::string& unparsed)
 {
   using ws_t = qi::rule<FwdIter>;
   ws_t whitespace = space | lit('#') >> *(char_ - eol) >> eol |
@@ -670,7 +683,7 @@ fhicl::parse_value_string(std::string const& s,
     begin == end;
   unparsed = std::string(begin, end);
   return b;
-} // parse_value_string()
+} // parse_value_string_grammar()
 
 // ----------------------------------------------------------------------
 
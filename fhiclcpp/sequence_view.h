@@ -0,0 +1,78 @@
+#ifndef fhiclcpp_sequence_view_h
+#define fhiclcpp_sequence_view_h
+
+/*
+  ======================================================================
+
+  sequence_view
+
+  ======================================================================
+
+  Read-only view of the values of a numeric sequence that a
+  ParameterSet stores packed (see ParameterSet::get_view).  The view
+  shares ownership of the values, so it remains valid after the
+  ParameterSet it came from has been modified or destroyed.
+
+*/
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace fhicl {
+
+  template <class T>
+  class sequence_view {
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using const_iterator = T const*;
+
+    sequence_view() = default;
+    explicit sequence_view(std::shared_ptr<std::vector<T> const> values)
+      : values_{std::move(values)}
+    {}
+
+    T const*
+    data() const noexcept
+    {
+      return values_ ? values_->data() : nullptr;
+    }
+    size_type
+    size() const noexcept
+    {
+      return values_ ? values_->size() : 0;
+    }
+    bool
+    empty() const noexcept
+    {
+      return size() == 0;
+    }
+
+    T const&
+    operator[](size_type const i) const noexcept
+    {
+      return data()[i];
+    }
+
+    const_iterator
+    begin() const noexcept
+    {
+      return data();
+    }
+    const_iterator
+    end() const noexcept
+    {
+      return data() + size();
+    }
+
+  private:
+    std::shared_ptr<std::vector<T> const> values_{};
+  };
+}
+
+#endif /* fhiclcpp_sequence_view_h */
+
+// Local Variables:
+// mode: c++
+// End:
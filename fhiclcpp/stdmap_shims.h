@@ -260,6 +260,42 @@ namespace shims {
       }
     }
 
+    // Lookup by anything Compare can compare with a Key, if it is
+    // transparent (e.g. std::less<>), without making a Key of it.
+    template <class K,
+              class C = Compare,
+              class = typename C::is_transparent>
+    iterator
+    find(K const& key)
+    {
+      if (isSnippetMode()) {
+        return std::find_if(
+          _maps.listmap.begin(), _maps.listmap.end(), [&key](auto& element) {
+            return element.first == key;
+          });
+      } else {
+        return _maps.mapmap.find(key);
+      }
+    }
+
+    template <class K,
+              class C = Compare,
+              class = typename C::is_transparent>
+    const_iterator
+    find(K const& key) const
+    {
+      maps_tuple& maps = *const_cast<maps_tuple*>(&_maps);
+
+      if (isSnippetMode()) {
+        return std::find_if(
+          maps.listmap.begin(),
+          maps.listmap.end(),
+          [&key](auto const& element) { return element.first == key; });
+      } else {
+        return maps.mapmap.find(key);
+      }
+    }
+
     size_t
     erase(Key const& key)
     {
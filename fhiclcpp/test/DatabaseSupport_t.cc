@@ -55,4 +55,17 @@ BOOST_AUTO_TEST_CASE(nested_vector)
   BOOST_TEST(records.size() == 3ul);
 }
 
+BOOST_AUTO_TEST_CASE(sequences_not_of_tables)
+{
+  std::vector<std::string> records;
+  std::vector<std::string> hashes;
+
+  // Only sequences that hold nothing but tables are descended into.
+  auto const p = fhicl::ParameterSet::make(
+    "a: [1, 2] b: [{ x: 1 }, 3] c: [{ x: 1 }, { x: 2 }] d: { y: [{ z: 1 }] }");
+  BOOST_CHECK_NO_THROW(fhicl::decompose_parameterset(p, records, hashes));
+  BOOST_TEST(records.size() == hashes.size());
+  BOOST_TEST(records.size() == 5ul);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
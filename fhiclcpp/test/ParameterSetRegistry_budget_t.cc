@@ -0,0 +1,172 @@
+// vim: set sw=2 expandtab :
+#define BOOST_TEST_MODULE (ParameterSetRegistry_budget_t)
+#include "boost/test/unit_test.hpp"
+
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/boost_test_print_pset.h"
+
+#include "sqlite3.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+using namespace std;
+
+using fhicl::detail::throwOnSQLiteFailure;
+
+// The budget is process-wide, hence the separate test module.
+
+namespace {
+  vector<ParameterSet>
+  make_psets(string const& label, size_t const n)
+  {
+    vector<ParameterSet> result;
+    for (size_t i = 0; i != n; ++i) {
+      result.push_back(ParameterSet::make(
+        label + ": " + to_string(i) +
+        " module: { type: \"Producer\" labels: [ a, b, c ] }"));
+    }
+    return result;
+  }
+
+  // A chain of depth tables, each nested in the next.
+  ParameterSet
+  make_nested(size_t const depth)
+  {
+    ParameterSet result;
+    for (size_t i = 0; i != depth; ++i) {
+      ParameterSet parent;
+      parent.put("level", i);
+      parent.put("labels", vector<string>{"a", "b", "c"});
+      parent.put("nested", result);
+      result = parent;
+    }
+    return result;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(ParameterSetRegistry_budget_t)
+
+BOOST_AUTO_TEST_CASE(Unbounded)
+{
+  auto const psets = make_psets("unbounded", 10);
+  ParameterSetRegistry::put(psets.cbegin(), psets.cend());
+  auto const usage = ParameterSetRegistry::memoryUsage();
+  BOOST_TEST(usage.budget == 0ull);
+  BOOST_TEST(usage.resident_entries == ParameterSetRegistry::size());
+  BOOST_TEST(usage.spilled_entries == 0ull);
+}
+
+BOOST_AUTO_TEST_CASE(Eviction)
+{
+  auto const psets = make_psets("evicted", 200);
+  ParameterSetRegistry::put(psets.cbegin(), psets.cend());
+  auto const size = ParameterSetRegistry::size();
+
+  ParameterSetRegistry::setMemoryBudget(1);
+  auto usage = ParameterSetRegistry::memoryUsage();
+  BOOST_TEST(usage.resident_bytes == 0ull);
+  BOOST_TEST(usage.resident_entries == 0ull);
+  BOOST_TEST(usage.spilled_entries == size);
+
+  ParameterSetRegistry::setMemoryBudget(1u << 16);
+  usage = ParameterSetRegistry::memoryUsage();
+  BOOST_TEST(usage.resident_bytes <= usage.budget);
+  BOOST_TEST(usage.resident_entries + usage.spilled_entries == size);
+  BOOST_TEST(ParameterSetRegistry::size() == size);
+
+  // Evicted entries are read back in on demand.
+  for (auto const& ps : psets) {
+    BOOST_TEST(ParameterSetRegistry::has(ps.id()));
+    ParameterSet const copy{ParameterSetRegistry::get(ps.id())};
+    BOOST_TEST(copy == ps);
+    BOOST_TEST(copy.get<string>("module.type") == "Producer");
+  }
+  usage = ParameterSetRegistry::memoryUsage();
+  BOOST_TEST(usage.resident_bytes <= usage.budget);
+  BOOST_TEST(ParameterSetRegistry::size() == size);
+}
+
+BOOST_AUTO_TEST_CASE(FrozenEntriesStay)
+{
+  ParameterSetRegistry::setMemoryBudget(0);
+  auto const pset = ParameterSet::make("frozen: { value: 42 }");
+  ParameterSetRegistry::put(pset);
+  ParameterSetRegistry::freeze();
+  ParameterSetRegistry::setMemoryBudget(1);
+  auto const usage = ParameterSetRegistry::memoryUsage();
+  BOOST_TEST(usage.resident_entries >= 2ull);
+  BOOST_TEST(ParameterSetRegistry::get(pset.id()).get<int>("frozen.value") ==
+             42);
+}
+
+BOOST_AUTO_TEST_CASE(SpillToFile)
+{
+  auto const filename =
+    (filesystem::temp_directory_path() / "ParameterSetRegistry_budget_t.db")
+      .string();
+  filesystem::remove(filename);
+  ParameterSetRegistry::spillTo(filename);
+  BOOST_TEST(filesystem::exists(filename));
+
+  auto const psets = make_psets("spilled", 100);
+  ParameterSetRegistry::put(psets.cbegin(), psets.cend());
+  BOOST_TEST(ParameterSetRegistry::memoryUsage().spilled_entries > 0ull);
+  for (auto const& ps : psets) {
+    BOOST_TEST(ParameterSetRegistry::get(ps.id()) == ps);
+  }
+
+  // Spilled entries go out with the rest of the registry.
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(!sqlite3_open(":memory:", &db));
+  ParameterSetRegistry::exportTo(db);
+  sqlite3_stmt* stmt = nullptr;
+  sqlite3_prepare_v2(
+    db, "SELECT COUNT(*) FROM ParameterSets;", -1, &stmt, nullptr);
+  throwOnSQLiteFailure(db);
+  BOOST_TEST_REQUIRE(sqlite3_step(stmt) == SQLITE_ROW);
+  BOOST_TEST(static_cast<size_t>(sqlite3_column_int64(stmt, 0)) >=
+             ParameterSetRegistry::size());
+  sqlite3_finalize(stmt);
+  BOOST_TEST_REQUIRE(sqlite3_close(db) == SQLITE_OK);
+}
+
+BOOST_AUTO_TEST_CASE(ExportDeeplyNested)
+{
+  ParameterSetRegistry::setMemoryBudget(0);
+  auto const top = make_nested(32);
+  ParameterSetRegistry::put(top);
+  auto const expected = top.to_compact_string();
+
+  // Each nested table looked up while serializing evicts the others.
+  ParameterSetRegistry::setMemoryBudget(1);
+  BOOST_TEST(top.to_compact_string() == expected);
+  BOOST_TEST(ParameterSetRegistry::get(top.id()).to_string() ==
+             top.to_string());
+  BOOST_TEST(top.get<size_t>("nested.nested.nested.level") == 28u);
+
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(!sqlite3_open(":memory:", &db));
+  ParameterSetRegistry::exportTo(db);
+  sqlite3_stmt* stmt = nullptr;
+  sqlite3_prepare_v2(
+    db, "SELECT PSetBlob FROM ParameterSets;", -1, &stmt, nullptr);
+  throwOnSQLiteFailure(db);
+  size_t matches{};
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    auto const* blob =
+      reinterpret_cast<char const*>(sqlite3_column_text(stmt, 0));
+    if (blob != nullptr && expected == blob) {
+      ++matches;
+    }
+  }
+  sqlite3_finalize(stmt);
+  BOOST_TEST(matches == 1u);
+  BOOST_TEST_REQUIRE(sqlite3_close(db) == SQLITE_OK);
+  ParameterSetRegistry::setMemoryBudget(0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 #include "boost/test/unit_test.hpp"
 
 #include "cetlib/container_algorithms.h"
+#include "cetlib/sha1.h"
 #include "fhiclcpp/ParameterSetRegistry.h"
 #include "fhiclcpp/test/boost_test_print_pset.h"
 #include "hep_concurrency/simultaneous_function_spawner.h"
@@ -10,8 +11,11 @@
 #include "sqlite3.h"
 
 #include <atomic>
+#include <filesystem>
 #include <functional>
+#include <iomanip>
 #include <mutex>
+#include <sstream>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -40,6 +44,24 @@ BOOST_AUTO_TEST_CASE(Typedefs)
     is_same_v<ctype::const_iterator, ParameterSetRegistry::const_iterator>);
 }
 
+BOOST_AUTO_TEST_CASE(IDStringRoundTrip)
+{
+  auto const id = ParameterSet::make("a: 1").id();
+  auto const str = id.to_string();
+  BOOST_TEST(str.size() == ParameterSetID::max_str_size());
+  BOOST_TEST(ParameterSetID{str} == id);
+  BOOST_TEST(detail::HashParameterSetID{}(ParameterSetID{str}) ==
+             detail::HashParameterSetID{}(id));
+  ostringstream oss;
+  oss << id;
+  BOOST_TEST(oss.str() == str);
+  BOOST_TEST(!ParameterSetID{""}.is_valid());
+  BOOST_CHECK_THROW(ParameterSetID{"0123"}, fhicl::exception);
+  auto bad = str;
+  bad[7] = 'g';
+  BOOST_CHECK_THROW(ParameterSetID{bad}, fhicl::exception);
+}
+
 BOOST_AUTO_TEST_CASE(MakeAndAdd)
 {
   BOOST_TEST_REQUIRE(ParameterSetRegistry::empty());
@@ -241,4 +263,240 @@ BOOST_AUTO_TEST_CASE(TestExport)
   sqlite3_close(db);
 }
 
+BOOST_AUTO_TEST_CASE(LazyImport)
+{
+  auto const pset = ParameterSet::make("lazy: [ 1, 2, 3 ]");
+  string const id{pset.id().to_string()};
+  string const blob{pset.to_compact_string()};
+  auto const filename =
+    (filesystem::temp_directory_path() / "ParameterSetRegistry_t_lazy.db")
+      .string();
+  filesystem::remove(filename);
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(!sqlite3_open(filename.c_str(), &db));
+  char* errMsg = nullptr;
+  sqlite3_exec(db,
+               ("CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);"
+                "INSERT INTO ParameterSets VALUES('" +
+                id + "', '" + blob + "');")
+                 .c_str(),
+               nullptr,
+               nullptr,
+               &errMsg);
+  throwOnSQLiteFailure(db, errMsg);
+
+  auto const size = ParameterSetRegistry::size();
+  ParameterSetRegistry::importFrom(db,
+                                   ParameterSetRegistry::import_mode::lazy);
+  BOOST_TEST_REQUIRE(sqlite3_close(db) == SQLITE_OK);
+  BOOST_TEST(!ParameterSetRegistry::has(pset.id()));
+  BOOST_TEST(ParameterSetRegistry::get(pset.id()) == pset);
+  BOOST_TEST(ParameterSetRegistry::size() == size + 1);
+  BOOST_CHECK_THROW(ParameterSetRegistry::get(ParameterSet::make("no: 1").id()),
+                    fhicl::exception);
+}
+
+BOOST_AUTO_TEST_CASE(StageIn)
+{
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(!sqlite3_open(":memory:", &db));
+  char* errMsg = nullptr;
+  sqlite3_exec(db,
+               "CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);",
+               nullptr,
+               nullptr,
+               &errMsg);
+  throwOnSQLiteFailure(db, errMsg);
+  vector<ParameterSet> psets;
+  for (int i = 0; i != 100; ++i) {
+    psets.push_back(ParameterSet::make("staged: " + to_string(i) +
+                                       " inner: { i: " + to_string(i) + " }"));
+    string const sql{"INSERT INTO ParameterSets VALUES('" +
+                     psets.back().id().to_string() + "', '" +
+                     psets.back().to_compact_string() + "');"};
+    sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg);
+    throwOnSQLiteFailure(db, errMsg);
+  }
+  ParameterSetRegistry::importFrom(db);
+  BOOST_TEST_REQUIRE(sqlite3_close(db) == SQLITE_OK);
+
+  auto const size = ParameterSetRegistry::size();
+  ParameterSetRegistry::stageIn();
+  BOOST_TEST(ParameterSetRegistry::size() >= size + psets.size());
+  for (auto const& pset : psets) {
+    BOOST_TEST_REQUIRE(ParameterSetRegistry::has(pset.id()));
+    BOOST_TEST(ParameterSetRegistry::get(pset.id()) == pset);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(PrefetchNested)
+{
+  // Blobs as written by exportTo, with nested tables by reference
+  // only.  None of these sets may be registered beforehand, so their
+  // IDs are computed here from their canonical strings.
+  auto id_of = [](string const& canonical) {
+    ostringstream oss;
+    oss << hex << setfill('0');
+    for (unsigned int const num : cet::sha1{canonical}.digest()) {
+      oss << setw(2) << num;
+    }
+    return oss.str();
+  };
+  auto const leaf = id_of("prefetch_leaf:1");
+  auto const middle = id_of("more:2 prefetch_middle:{prefetch_leaf:1}");
+  auto const top = id_of(
+    "prefetch_top:[{more:2 prefetch_middle:{prefetch_leaf:1}},"
+    "{prefetch_leaf:1}]");
+  vector<pair<string, string>> const rows{
+    {leaf, "prefetch_leaf:1"},
+    {middle, "more:2 prefetch_middle:@id::" + leaf},
+    {top, "prefetch_top:[@id::" + middle + ",@id::" + leaf + "]"}};
+
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(!sqlite3_open(":memory:", &db));
+  char* errMsg = nullptr;
+  sqlite3_exec(db,
+               "CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);",
+               nullptr,
+               nullptr,
+               &errMsg);
+  throwOnSQLiteFailure(db, errMsg);
+  for (auto const& [id, blob] : rows) {
+    string const sql{"INSERT INTO ParameterSets VALUES('" + id + "', '" +
+                     blob + "');"};
+    sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg);
+    throwOnSQLiteFailure(db, errMsg);
+  }
+  ParameterSetRegistry::importFrom(db);
+  BOOST_TEST_REQUIRE(sqlite3_close(db) == SQLITE_OK);
+
+  // Looking up the top-level set fetches its descendants too, but
+  // does not register them.
+  auto const size = ParameterSetRegistry::size();
+  ParameterSetID const top_id{top};
+  ParameterSetID const middle_id{middle};
+  BOOST_TEST_REQUIRE(!ParameterSetRegistry::has(top_id));
+  ParameterSetRegistry::resetStatistics();
+  auto const& got = ParameterSetRegistry::get(top_id);
+  BOOST_TEST(ParameterSetRegistry::size() == size + 1);
+  BOOST_TEST(!ParameterSetRegistry::has(middle_id));
+  // One query for the set, and one for its two descendants.
+  auto stats = ParameterSetRegistry::statistics();
+  BOOST_TEST(stats.fallbacks == 1ull);
+  BOOST_TEST(stats.prefetched == 0ull);
+  BOOST_TEST(stats.queries == 2ull);
+
+  // The descendants are then made from the prefetched blobs, with no
+  // further query.
+  auto const nested = got.get<vector<ParameterSet>>("prefetch_top");
+  BOOST_TEST_REQUIRE(nested.size() == 2ul);
+  stats = ParameterSetRegistry::statistics();
+  BOOST_TEST(stats.fallbacks == 3ull);
+  BOOST_TEST(stats.prefetched == 2ull);
+  BOOST_TEST(stats.queries == 2ull);
+  BOOST_TEST(nested[0].id() == middle_id);
+  BOOST_TEST(nested[1].id() == ParameterSetID{leaf});
+  BOOST_TEST(nested[0].get<int>("prefetch_middle.prefetch_leaf") == 1);
+  BOOST_TEST(got.id() == top_id);
+}
+
+BOOST_AUTO_TEST_CASE(ConcurrentMisses)
+{
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(!sqlite3_open(":memory:", &db));
+  char* errMsg = nullptr;
+  sqlite3_exec(db,
+               "CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);",
+               nullptr,
+               nullptr,
+               &errMsg);
+  throwOnSQLiteFailure(db, errMsg);
+  vector<ParameterSet> psets;
+  for (int i = 0; i != 32; ++i) {
+    psets.push_back(ParameterSet::make("missed: " + to_string(i)));
+    string const sql{"INSERT INTO ParameterSets VALUES('" +
+                     psets.back().id().to_string() + "', '" +
+                     psets.back().to_compact_string() + "');"};
+    sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg);
+    throwOnSQLiteFailure(db, errMsg);
+  }
+  ParameterSetRegistry::importFrom(db);
+  BOOST_TEST_REQUIRE(sqlite3_close(db) == SQLITE_OK);
+
+  // Every lookup misses the registry and falls back to the DB; the
+  // results are checked afterwards since Boost.Test is not
+  // thread-safe.
+  auto const size = ParameterSetRegistry::size();
+  vector<char> matched(psets.size());
+  vector<function<void()>> tasks;
+  for (size_t i = 0; i != psets.size(); ++i) {
+    tasks.push_back([&psets, &matched, i] {
+      matched[i] = ParameterSetRegistry::get(psets[i].id()) == psets[i];
+    });
+  }
+  simultaneous_function_spawner sfs{tasks};
+  for (auto const m : matched) {
+    BOOST_TEST(m);
+  }
+  BOOST_TEST(ParameterSetRegistry::size() == size + psets.size());
+}
+
+BOOST_AUTO_TEST_CASE(Statistics)
+{
+  ParameterSetRegistry::resetStatistics();
+  auto const pset = ParameterSet::make("statistics: 1 counted: true");
+  ParameterSetRegistry::put(pset);
+  ParameterSetRegistry::put(pset);
+  BOOST_TEST(ParameterSetRegistry::get(pset.id()) == pset);
+  ParameterSet missing;
+  BOOST_TEST(!ParameterSetRegistry::get(
+    ParameterSet::make("not_registered: 1").id(), missing));
+
+  auto const stats = ParameterSetRegistry::statistics();
+  BOOST_TEST(stats.puts == 2ull);
+  BOOST_TEST(stats.duplicate_puts == 1ull);
+  BOOST_TEST(stats.lookups == 2ull);
+  BOOST_TEST(stats.hits == 1ull);
+  BOOST_TEST(stats.misses == 1ull);
+  BOOST_TEST(stats.fallbacks == 0ull);
+  BOOST_TEST(stats.lock_waits[0] >= 3ull);
+
+  ostringstream os;
+  os << stats;
+  BOOST_TEST(os.str().find("lookups:      2 (hits: 1, misses: 1)") !=
+             string::npos);
+
+  ParameterSetRegistry::resetStatistics();
+  BOOST_TEST(ParameterSetRegistry::statistics().lookups == 0ull);
+}
+
+BOOST_AUTO_TEST_CASE(Freeze)
+{
+  // Must be the last test: the registry cannot be thawed.
+  auto const before = ParameterSet::make("frozen: { a: 1 }");
+  ParameterSetRegistry::put(before);
+  auto const size = ParameterSetRegistry::size();
+  BOOST_TEST_REQUIRE(!ParameterSetRegistry::frozen());
+  ParameterSetRegistry::freeze();
+  BOOST_TEST_REQUIRE(ParameterSetRegistry::frozen());
+  BOOST_TEST(ParameterSetRegistry::has(before.id()));
+  BOOST_TEST(ParameterSetRegistry::get(before.id()) == before);
+  BOOST_TEST(ParameterSetRegistry::size() == size);
+
+  // Overflow.
+  auto const after = ParameterSet::make("thawed: 2");
+  ParameterSetRegistry::put(after);
+  BOOST_TEST(ParameterSetRegistry::has(after.id()));
+  BOOST_TEST(ParameterSetRegistry::size() == size + 1);
+
+  // Reject.
+  ParameterSetRegistry::freeze(
+    ParameterSetRegistry::frozen_put_policy::reject);
+  BOOST_TEST(ParameterSetRegistry::put(after) == after.id());
+  BOOST_TEST(ParameterSetRegistry::put(before) == before.id());
+  BOOST_CHECK_THROW(ParameterSetRegistry::put(ParameterSet::make("new: 3")),
+                    fhicl::exception);
+  BOOST_TEST(ParameterSetRegistry::size() == size + 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -1,15 +1,40 @@
 #define BOOST_TEST_MODULE (ParameterSet test)
 
 #include "boost/test/unit_test.hpp"
+#include "cetlib/sha1.h"
 #include "fhiclcpp/ParameterSet.h"
 #include "fhiclcpp/test/boost_test_print_pset.h"
+#include "hep_concurrency/simultaneous_function_spawner.h"
 
+#include <array>
+#include <complex>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <optional>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace fhicl;
 
+namespace {
+  std::string
+  sha1_string(std::string const& text)
+  {
+    cet::sha1 sha{text.c_str()};
+    std::ostringstream oss;
+    oss << std::hex << std::setfill('0');
+    for (unsigned int const num : sha.digest()) {
+      oss << std::setw(2) << num;
+    }
+    return oss.str();
+  }
+}
+
 struct SampleConfigFixture {
   SampleConfigFixture();
 
@@ -338,4 +363,371 @@ BOOST_AUTO_TEST_CASE(Custom)
   BOOST_CHECK_THROW(pset.get_if_present("e", u, hex), std::string);
 }
 
+BOOST_AUTO_TEST_CASE(typed_atoms)
+{
+  // Typed retrieval of stored atoms must agree with what the parser
+  // would make of their text.
+  auto const ps = fhicl::ParameterSet::make(
+    "i: -17 u: 12345678 d: 2.5e-3 inf: -infinity t: true f: false n: @nil "
+    "s: \"plain\" e: \"tab\\there\" q: \"42\" qb: \"true\" "
+    "c: (1, -2) big: 1e30 seq: [ 1, 2.5, \"x\" ]");
+  BOOST_TEST(ps.get<int>("i") == -17);
+  BOOST_TEST(ps.get<unsigned long>("u") == 12345678ul);
+  BOOST_TEST(ps.get<double>("d") == 2.5e-3);
+  BOOST_TEST(ps.get<double>("inf") == -std::numeric_limits<double>::infinity());
+  BOOST_TEST(ps.get<bool>("t"));
+  BOOST_TEST(!ps.get<bool>("f"));
+  BOOST_TEST(ps.get<std::string>("s") == "plain");
+  BOOST_TEST(ps.get<std::string>("e") == "tab\there");
+  BOOST_TEST(ps.get<std::string>("i") == "-17");
+  BOOST_TEST(ps.get<int>("q") == 42);
+  BOOST_TEST(ps.get<bool>("qb"));
+  BOOST_TEST(ps.get<std::complex<double>>("c") ==
+             std::complex<double>(1., -2.));
+  BOOST_TEST(ps.get<std::string>("seq[2]") == "x");
+  BOOST_TEST(ps.get<double>("seq[1]") == 2.5);
+
+  BOOST_CHECK_THROW(ps.get<int>("d"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.get<unsigned>("i"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.get<int>("big"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.get<int>("s"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.get<bool>("i"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.get<std::string>("n"), fhicl::exception);
+  BOOST_TEST(ps.is_key_to_atom("n"));
+  BOOST_TEST(ps.to_string() ==
+             "big:1e30 c:(1,-2) d:2.5e-3 e:\"tab\\there\" f:false i:-17 "
+             "inf:-infinity n:@nil q:\"42\" qb:\"true\" s:\"plain\" "
+             "seq:[1,2.5,\"x\"] t:true u:1.2345678e7");
+}
+
+BOOST_AUTO_TEST_CASE(typed_integer_limits)
+{
+  // Overflow and narrowing are decided exactly, not on a rounded value.
+  auto const ps = fhicl::ParameterSet::make(
+    "imax: 9223372036854775807 imin: -9223372036854775808 "
+    "over: 9223372036854775808 umax: 18446744073709551615 "
+    "uover: 18446744073709551616 tiny: 1e-5000 big: 9007199254740993 "
+    "half: -0.5");
+  BOOST_TEST(ps.get<long long>("imax") ==
+             std::numeric_limits<long long>::max());
+  BOOST_TEST(ps.get<long long>("imin") ==
+             std::numeric_limits<long long>::min());
+  BOOST_TEST(ps.get<unsigned long long>("over") == 9223372036854775808ull);
+  BOOST_TEST(ps.get<unsigned long long>("umax") ==
+             std::numeric_limits<unsigned long long>::max());
+  BOOST_TEST(ps.get<long long>("big") == 9007199254740993ll);
+  BOOST_TEST(ps.get<double>("big") == 9007199254740992.);
+
+  BOOST_CHECK_THROW(ps.get<long long>("over"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.get<unsigned long long>("uover"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.get<unsigned>("imin"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.get<int>("tiny"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.get<unsigned>("half"), fhicl::exception);
+  BOOST_TEST(ps.get<double>("tiny") == 0.);
+}
+
+BOOST_AUTO_TEST_CASE(bulk_sequence_decode)
+{
+  // Long enough to be decoded in parallel.
+  std::size_t const n{100000};
+  std::vector<double> values(n);
+  std::vector<int> ints(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    values[i] = 0.25 * i - 1000.;
+    ints[i] = static_cast<int>(i) - 50;
+  }
+  ParameterSet ps;
+  ps.put("values", values);
+  ps.put("ints", ints);
+  BOOST_TEST(ps.get<std::vector<double>>("values") == values);
+  BOOST_TEST(ps.get<std::vector<float>>("ints").back() == n - 51.f);
+  BOOST_TEST(ps.get<std::vector<int>>("ints") == ints);
+  BOOST_TEST(ps.get<std::vector<long long>>("ints") ==
+             std::vector<long long>(ints.begin(), ints.end()));
+  BOOST_TEST(ps.get<double>("values[4]") == -999.);
+  BOOST_CHECK_THROW(ps.get<std::vector<int>>("values"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.get<std::vector<unsigned>>("ints"), fhicl::exception);
+
+  // An element that is not a number fails as it would on its own.
+  auto mixed = ps.get<std::vector<std::string>>("values");
+  mixed.back() = "x";
+  ps.put("mixed", mixed);
+  BOOST_CHECK_THROW(ps.get<std::vector<double>>("mixed"), fhicl::exception);
+  BOOST_TEST(ps.get<double>("mixed[0]") == -1000.);
+}
+
+BOOST_AUTO_TEST_CASE(packed_sequences)
+{
+  auto const ps = fhicl::ParameterSet::make(
+    "reals: [0.1, 2.5, -3, 1234567] ints: [1, -2, 1234567] "
+    "long: [1.00000000000000000001] nested: [[1, 2], [3, 4]]");
+  // Printing (and so the ID) is that of the stored text.
+  BOOST_TEST(ps.to_string() ==
+             "ints:[1,-2,1.234567e6] long:[1.00000000000000000001] "
+             "nested:[[1,2],[3,4]] reals:[1e-1,2.5,-3,1.234567e6]");
+  BOOST_TEST(ps.id() == fhicl::ParameterSet::make(ps.to_string()).id());
+
+  auto const reals = ps.get_view<double>("reals");
+  BOOST_TEST_REQUIRE(reals.has_value());
+  BOOST_TEST(std::vector<double>(reals->begin(), reals->end()) ==
+             (std::vector<double>{0.1, 2.5, -3., 1234567.}));
+  BOOST_TEST(!ps.get_view<std::intmax_t>("reals"));
+  auto const ints = ps.get_view<std::intmax_t>("ints");
+  BOOST_TEST_REQUIRE(ints.has_value());
+  BOOST_TEST(ints->size() == 3u);
+  BOOST_TEST((*ints)[1] == -2);
+  BOOST_TEST(!ps.get_view<double>("long"));
+  BOOST_TEST(ps.get_view<std::intmax_t>("nested[1]")->size() == 2u);
+  BOOST_TEST(!ps.get_view<double>("absent"));
+
+  BOOST_TEST(ps.get<std::vector<int>>("ints") ==
+             (std::vector<int>{1, -2, 1234567}));
+  BOOST_TEST(ps.get<std::vector<std::string>>("ints") ==
+             (std::vector<std::string>{"1", "-2", "1.234567e6"}));
+  BOOST_TEST(ps.get<int>("ints[1]") == -2);
+  BOOST_TEST(ps.get<std::string>("reals[0]") == "1e-1");
+  BOOST_TEST(ps.get<std::vector<std::vector<int>>>("nested")[1][0] == 3);
+  BOOST_TEST((ps.get<std::array<int, 3>>("ints")[2]) == 1234567);
+  BOOST_TEST(ps.has_key("ints[2]"));
+  BOOST_TEST(!ps.has_key("ints[3]"));
+  BOOST_TEST(ps.is_key_to_sequence("reals"));
+  BOOST_TEST(ps.is_key_to_atom("reals[1]"));
+  BOOST_CHECK_THROW(ps.get<std::vector<int>>("reals"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.get<std::vector<unsigned>>("ints"), fhicl::exception);
+
+  // Values put from C++ keep the text encode gives them, and views
+  // outlive the ParameterSet they came from.
+  std::vector<double> const values{0.1, 1e30, -7., 1. / 3};
+  std::optional<fhicl::sequence_view<double>> view;
+  {
+    ParameterSet put;
+    put.put("values", values);
+    BOOST_TEST(put.to_string() ==
+               "values:[1.00000000000000005551e-1,1.00000000000000001988e30,"
+               "-7,3.3333333333333331483e-1]");
+    view = put.get_view<double>("values");
+  }
+  BOOST_TEST_REQUIRE(view.has_value());
+  BOOST_TEST(std::vector<double>(view->begin(), view->end()) == values);
+}
+
+BOOST_AUTO_TEST_CASE(nested_lookup)
+{
+  auto const ps = fhicl::ParameterSet::make(
+    "a: { b: { c: { d: 42 } } seq: [{ x: 1 }, { x: 2 }] atom: 3 } "
+    "e: @nil");
+  BOOST_TEST(ps.get<int>("a.b.c.d") == 42);
+  BOOST_TEST(ps.get<int>("a.seq[1].x") == 2);
+  BOOST_TEST(ps.get_if_present<int>("a.b.c.d").value_or(0) == 42);
+  BOOST_TEST(!ps.get_if_present<int>("a.b.x.d"));
+  BOOST_TEST(!ps.get_if_present<int>("a.atom.d"));
+  BOOST_TEST(!ps.get_if_present<int>("e.d"));
+  BOOST_TEST(ps.get<fhicl::ParameterSet>("a.b.c").get<int>("d") == 42);
+  BOOST_TEST(ps.has_key("a.b.c.d"));
+  BOOST_TEST(ps.has_key("a.seq[0].x"));
+  BOOST_TEST(!ps.has_key("a.seq[2].x"));
+  BOOST_TEST(!ps.has_key("a.atom.d"));
+  BOOST_TEST(ps.is_key_to_table("a.b.c"));
+  BOOST_TEST(ps.is_key_to_atom("a.b.c.d"));
+  BOOST_TEST(ps.is_key_to_sequence("a.seq"));
+  BOOST_CHECK_THROW(ps.is_key_to_atom("a.x.d"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.get<int>("a.b.x"), fhicl::exception);
+}
+
+BOOST_AUTO_TEST_CASE(precompiled_keys)
+{
+  auto const ps = fhicl::ParameterSet::make(
+    "a: { b: [[0, 1], [{ c: 4 }]] d: 2.5 } e: [1, 2]");
+  fhicl::Key const c{"a.b[1][0].c"};
+  BOOST_TEST(c.to_string() == "a.b[1][0].c");
+  BOOST_TEST(ps.get<int>(c) == 4);
+  BOOST_TEST(ps.get<int>(fhicl::Key{"a..b[0][1]"}) == 1);
+  BOOST_TEST(ps.get<int>(fhicl::Key{"a.x"}, 7) == 7);
+  BOOST_TEST(ps.get_if_present<double>(fhicl::Key{"a.d"}).value_or(0.) == 2.5);
+  int value{};
+  BOOST_TEST(ps.get_if_present(fhicl::Key{"e[1]"}, value));
+  BOOST_TEST(value == 2);
+  BOOST_TEST(ps.get_view<std::intmax_t>(fhicl::Key{"e"})->size() == 2u);
+  BOOST_TEST(ps.has_key(c));
+  BOOST_TEST(!ps.has_key(fhicl::Key{"a.b[2]"}));
+  BOOST_TEST(ps.is_key_to_table(fhicl::Key{"a"}));
+  BOOST_TEST(ps.is_key_to_sequence(fhicl::Key{"a.b[0]"}));
+  BOOST_TEST(ps.is_key_to_atom(fhicl::Key{"a.d"}));
+  BOOST_CHECK_EXCEPTION(ps.get<int>(fhicl::Key{"a.x"}),
+                        fhicl::exception,
+                        [](auto const& e) {
+                          return e.categoryCode() == fhicl::error::cant_find;
+                        });
+  for (auto const* malformed : {"", ".", "a[", "a[]", "a[1]x", "a[-1]"}) {
+    BOOST_CHECK_THROW(fhicl::Key{malformed}, fhicl::exception);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(string_view_keys)
+{
+  // Keys that are views into a longer string, not null-terminated.
+  std::string const text{"a.b.c[1]x y"};
+  std::string_view const all{text};
+  auto const nested = all.substr(0, 5);
+  auto const indexed = all.substr(0, 8);
+  auto const local = all.substr(8, 1);
+  auto const absent = all.substr(10, 1);
+
+  auto ps = fhicl::ParameterSet::make("a: { b: { c: [3, 4] } } x: 5");
+  BOOST_TEST(ps.get<std::vector<int>>(nested).size() == 2u);
+  BOOST_TEST(ps.get<int>(indexed) == 4);
+  BOOST_TEST(ps.get<int>(local) == 5);
+  BOOST_TEST(ps.get<int>(absent, 6) == 6);
+  BOOST_TEST(ps.get_if_present<int>(indexed).value_or(0) == 4);
+  BOOST_TEST(!ps.get_if_present<int>(absent));
+  BOOST_TEST(ps.has_key(local));
+  BOOST_TEST(!ps.has_key(absent));
+  BOOST_TEST(ps.is_key_to_sequence(nested));
+  BOOST_TEST(ps.is_key_to_atom(indexed));
+  BOOST_TEST(ps.get_src_info(absent).empty());
+
+  ps.put(absent, 7);
+  BOOST_TEST(ps.get<int>("y") == 7);
+  ps.put_or_replace(local, 8);
+  BOOST_TEST(ps.get<int>("x") == 8);
+  BOOST_TEST(ps.erase(absent));
+  BOOST_TEST(!ps.has_key("y"));
+  BOOST_CHECK_THROW(ps.put(nested, 1), fhicl::exception);
+}
+
+BOOST_AUTO_TEST_CASE(kind_of_and_try_get)
+{
+  auto const ps = fhicl::ParameterSet::make(
+    "a: 3 b: @nil c: [1, 2.5] d: { e: [{ f: 1 }, { f: 2 }] } g: 'x' "
+    "h: [1, 'y'] i: true j: [[1, 2], [3]] k: 3000000000");
+  BOOST_TEST((ps.kind_of("a") == value_kind::atom));
+  BOOST_TEST((ps.kind_of("b") == value_kind::nil));
+  BOOST_TEST((ps.kind_of("c") == value_kind::sequence));
+  BOOST_TEST((ps.kind_of("c[1]") == value_kind::atom));
+  BOOST_TEST((ps.kind_of("d") == value_kind::table));
+  BOOST_TEST((ps.kind_of("d.e[1]") == value_kind::table));
+  BOOST_TEST((ps.kind_of("x") == value_kind::absent));
+  BOOST_TEST((ps.kind_of("c[2]") == value_kind::absent));
+  BOOST_TEST((ps.kind_of("a.b") == value_kind::absent));
+  BOOST_TEST((ps.kind_of(fhicl::Key{"d.e"}) == value_kind::sequence));
+  // Indexing an atom or a table finds nothing.
+  BOOST_TEST((ps.kind_of("a[0]") == value_kind::absent));
+  BOOST_TEST((ps.kind_of("c[1][0]") == value_kind::absent));
+  BOOST_TEST((ps.kind_of("d[0]") == value_kind::absent));
+  BOOST_TEST(!ps.has_key("a[0]"));
+
+  auto const a = ps.try_get<int>("a");
+  BOOST_TEST(a.has_value());
+  BOOST_TEST(*a == 3);
+  BOOST_TEST(ps.try_get<double>("c[1]").value_or(0.) == 2.5);
+  BOOST_TEST(ps.try_get<std::string>("g").value_or("") == "x");
+  BOOST_TEST(ps.try_get<bool>("i").value_or(false));
+  BOOST_TEST(ps.try_get<std::vector<double>>("c")->size() == 2u);
+  BOOST_TEST(ps.try_get<std::vector<std::vector<int>>>("j")->size() == 2u);
+  BOOST_TEST(ps.try_get<long long>("k").value_or(0) == 3000000000);
+  auto const tables = ps.try_get<std::vector<ParameterSet>>(Key{"d.e"});
+  BOOST_TEST(tables.has_value());
+  BOOST_TEST(tables->at(1).get<int>("f") == 2);
+
+  auto const absent = ps.try_get<int>("x");
+  BOOST_TEST(absent.absent());
+  BOOST_TEST(!absent.type_mismatch());
+  BOOST_TEST(!absent);
+  BOOST_TEST(ps.try_get<int>("d[0]").absent());
+  BOOST_TEST(ps.try_get<int>("a[0]").absent());
+  for (auto const& mismatch : {ps.try_get<int>("c"),
+                               ps.try_get<int>("c[1]"),
+                               ps.try_get<int>("d"),
+                               ps.try_get<int>("b"),
+                               ps.try_get<int>("i"),
+                               ps.try_get<int>("k")}) {
+    BOOST_TEST(mismatch.type_mismatch());
+    BOOST_TEST(!mismatch.absent());
+  }
+  BOOST_TEST(ps.try_get<std::string>("b").type_mismatch());
+  BOOST_TEST(ps.try_get<ParameterSet>("a").type_mismatch());
+  BOOST_TEST(ps.try_get<std::vector<int>>("d").type_mismatch());
+  BOOST_TEST(ps.try_get<std::vector<int>>("h").type_mismatch());
+  BOOST_TEST(ps.try_get<std::vector<ParameterSet>>("c").type_mismatch());
+  BOOST_TEST((ps.try_get<std::array<int, 3>>("c").kind() ==
+              value_kind::sequence));
+  BOOST_TEST((ps.try_get<std::array<int, 3>>("c").type_mismatch()));
+
+  // The throwing interfaces are unchanged.
+  BOOST_CHECK_THROW(ps.get<int>("c"), fhicl::exception);
+  BOOST_CHECK_THROW(ps.is_key_to_atom("x"), fhicl::exception);
+  BOOST_TEST(ps.is_key_to_atom("b"));
+}
+
+BOOST_AUTO_TEST_CASE(copy_on_write)
+{
+  auto const original_string = pset.to_string();
+  auto const original_id = pset.id();
+
+  ParameterSet copy{pset};
+  BOOST_TEST(copy == pset);
+  copy.put("added", 1);
+  copy.put_or_replace("j", 2);
+  BOOST_TEST(copy.erase("m"));
+  BOOST_TEST(!copy.erase("absent"));
+  BOOST_TEST(copy.get<int>("added") == 1);
+  BOOST_TEST(copy.get<int>("j") == 2);
+  BOOST_TEST(!copy.has_key("m"));
+  BOOST_TEST(copy != pset);
+  BOOST_TEST(pset.to_string() == original_string);
+  BOOST_TEST(pset.id() == original_id);
+
+  // Tables retrieved from a ParameterSet, and the registry's own
+  // copies of them, are unaffected by changes to the retrieved copy.
+  auto nested = pset.get<ParameterSet>("j");
+  auto const nested_id = nested.id();
+  nested.put_or_replace("y", 7);
+  BOOST_TEST(pset.get<int>("j.y") == -1);
+  BOOST_TEST(pset.get<ParameterSet>("j").id() == nested_id);
+
+  ParameterSet moved{std::move(copy)};
+  BOOST_TEST(moved.get<int>("added") == 1);
+  copy = pset;
+  BOOST_TEST(copy == pset);
+  ParameterSet empty;
+  BOOST_TEST(empty.is_empty());
+  BOOST_TEST(empty == ParameterSet{});
+}
+
+BOOST_AUTO_TEST_CASE(id_matches_string_digest)
+{
+  // The ID is streamed into the digest; it must equal the hash of the
+  // full string form, including for sets larger than the sink buffer.
+  fhicl::ParameterSet big;
+  for (int i = 0; i != 50; ++i) {
+    fhicl::ParameterSet inner;
+    inner.put("name", "inner_" + std::to_string(i));
+    inner.put("values", std::vector<double>(20, 1.5 * i));
+    inner.put("nested", pset);
+    big.put("table_" + std::to_string(i), inner);
+  }
+  big.put("seq", std::vector<fhicl::ParameterSet>(3, pset));
+  auto const str = big.to_string();
+  BOOST_TEST_REQUIRE(str.size() > 4096u);
+  BOOST_TEST(big.id().to_string() == sha1_string(str));
+  BOOST_TEST(pset.id().to_string() == sha1_string(pset.to_string()));
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_id)
+{
+  // Many threads asking a shared, const ParameterSet for its ID must
+  // all see the same, fully-computed value.
+  fhicl::ParameterSet const shared{pset};
+  std::vector<fhicl::ParameterSetID> ids(8);
+  std::vector<std::function<void()>> tasks;
+  for (auto& id : ids) {
+    tasks.push_back([&id, &shared] { id = shared.id(); });
+  }
+  hep::concurrency::simultaneous_function_spawner sfs{tasks};
+  for (auto const& id : ids) {
+    BOOST_TEST(id == pset.id());
+  }
+  BOOST_TEST(shared == pset);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
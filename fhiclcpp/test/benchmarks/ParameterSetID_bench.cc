@@ -0,0 +1,127 @@
+// ======================================================================
+//
+// ParameterSetID_bench: hashing, formatting and parsing of
+//                       ParameterSetIDs, and registry lookup throughput.
+//
+// The "legacy" variants reproduce the string-based implementations
+// that were used before the digest was hashed and hex-encoded
+// directly.
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/benchmarks/bench_utils.h"
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+
+  // The digest bytes are not public; recover them cheaply from the hex
+  // form so that only the legacy ostringstream formatting is measured.
+  std::string
+  legacy_to_string(ParameterSetID const& id)
+  {
+    char buf[ParameterSetID::max_str_size()];
+    id.to_chars(buf);
+    auto value = [](char const c) { return c <= '9' ? c - '0' : c - 'a' + 10; };
+    std::ostringstream oss;
+    oss << std::hex << std::setfill('0');
+    for (std::size_t i = 0; i != sizeof buf; i += 2) {
+      unsigned int const num = value(buf[i]) << 4 | value(buf[i + 1]);
+      oss << std::setw(2) << num;
+    }
+    return oss.str();
+  }
+
+  struct LegacyHash {
+    std::size_t
+    operator()(ParameterSetID const& id) const
+    {
+      return std::hash<std::string>{}(legacy_to_string(id));
+    }
+  };
+
+  cet::sha1::digest_t
+  legacy_parse(std::string const& id)
+  {
+    cet::sha1::digest_t result{};
+    for (std::size_t i = 0, e = result.size(); i != e; ++i) {
+      result[i] = std::stoi(id.substr(i * 2, 2), nullptr, 16);
+    }
+    return result;
+  }
+
+  template <typename Hash>
+  double
+  lookup_ns(std::vector<ParameterSetID> const& ids, std::size_t const n)
+  {
+    std::unordered_map<ParameterSetID, int, Hash> m;
+    for (auto const& id : ids) {
+      m.emplace(id, 0);
+    }
+    return bench::ns_per_op(n, [&m, &ids](std::size_t const i) {
+      bench::keep(m.find(ids[i % ids.size()]));
+    });
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const scale = bench::scale(argc, argv);
+  std::size_t const nsets = 1000 * scale;
+  std::size_t const n = 100000 * scale;
+
+  std::vector<ParameterSetID> ids;
+  std::vector<std::string> id_strings;
+  for (std::size_t i = 0; i != nsets; ++i) {
+    ParameterSet ps;
+    ps.put("index", i);
+    ids.push_back(ParameterSetRegistry::put(ps));
+    id_strings.push_back(ids.back().to_string());
+  }
+
+  bench::report("map lookup (legacy string hash)",
+                lookup_ns<LegacyHash>(ids, n));
+  bench::report("map lookup (digest hash)",
+                lookup_ns<detail::HashParameterSetID>(ids, n));
+  bench::report("ParameterSetRegistry::has",
+                bench::ns_per_op(n, [&ids](std::size_t const i) {
+                  bench::keep(ParameterSetRegistry::has(ids[i % ids.size()]));
+                }));
+  bench::report("ParameterSetRegistry::get",
+                bench::ns_per_op(n, [&ids](std::size_t const i) {
+                  bench::keep(ParameterSetRegistry::get(ids[i % ids.size()]));
+                }));
+
+  bench::report("format (legacy ostringstream)",
+                bench::ns_per_op(n, [&ids](std::size_t const i) {
+                  bench::keep(legacy_to_string(ids[i % ids.size()]));
+                }));
+  bench::report("format (to_string)",
+                bench::ns_per_op(n, [&ids](std::size_t const i) {
+                  bench::keep(ids[i % ids.size()].to_string());
+                }));
+  bench::report("format (to_chars)",
+                bench::ns_per_op(n, [&ids](std::size_t const i) {
+                  char buf[ParameterSetID::max_str_size()];
+                  ids[i % ids.size()].to_chars(buf);
+                  bench::keep(buf);
+                }));
+
+  bench::report("parse (legacy substr/stoi)",
+                bench::ns_per_op(n, [&id_strings](std::size_t const i) {
+                  bench::keep(legacy_parse(id_strings[i % id_strings.size()]));
+                }));
+  bench::report("parse (ParameterSetID c'tor)",
+                bench::ns_per_op(n, [&id_strings](std::size_t const i) {
+                  bench::keep(
+                    ParameterSetID{id_strings[i % id_strings.size()]});
+                }));
+}
@@ -0,0 +1,60 @@
+// ======================================================================
+//
+// ParameterSetRegistry_bench: registry contention under concurrent
+//                             nested-table lookups.
+//
+// Each thread repeatedly retrieves a value three tables deep, so that
+// every call goes through ParameterSetRegistry::get once per level.
+// The reported figure is wall-clock time divided by the total number
+// of lookups across all threads.  The registry statistics, including
+// the shard lock-wait histogram, are printed at the end.
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/benchmarks/bench_utils.h"
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace fhicl;
+
+int
+main(int argc, char** argv)
+{
+  auto const scale = bench::scale(argc, argv);
+  std::size_t const nsets = 256;
+  std::size_t const n = 2000 * scale;
+
+  std::vector<ParameterSet> psets;
+  for (std::size_t i = 0; i != nsets; ++i) {
+    psets.push_back(ParameterSet::make(
+      "outer: { middle: { inner: { value: " + std::to_string(i) + " } } }"));
+  }
+
+  for (unsigned nthreads = 1; nthreads <= 64; nthreads *= 2) {
+    auto const start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t != nthreads; ++t) {
+      threads.emplace_back([&psets, n, t] {
+        for (std::size_t i = 0; i != n; ++i) {
+          auto const& ps = psets[(i + t) % psets.size()];
+          bench::keep(ps.get<int>("outer.middle.inner.value"));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    std::chrono::duration<double, std::nano> const elapsed =
+      std::chrono::steady_clock::now() - start;
+    bench::report("nested lookup, " + std::to_string(nthreads) + " threads",
+                  elapsed.count() / (n * nthreads));
+  }
+  std::cout << ParameterSetRegistry::statistics();
+}
@@ -0,0 +1,108 @@
+// ======================================================================
+//
+// ParameterSetRegistry_export_bench: writing the registry to a
+//                                    file-backed SQLite DB.
+//
+// The "legacy" variant reproduces the previous exportTo, which
+// committed each row separately.  Both targets are opened with
+// 'PRAGMA synchronous = OFF' to keep the default run short; with
+// synchronous writes the per-row commits cost considerably more.
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/benchmarks/bench_utils.h"
+
+#include "sqlite3.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+using namespace fhicl;
+using fhicl::detail::throwOnSQLiteFailure;
+
+namespace {
+
+  sqlite3*
+  open_target(std::string const& filename)
+  {
+    std::remove(filename.c_str());
+    sqlite3* db = nullptr;
+    sqlite3_open(filename.c_str(), &db);
+    throwOnSQLiteFailure(db);
+    char* errMsg = nullptr;
+    sqlite3_exec(db, "PRAGMA synchronous = OFF;", nullptr, nullptr, &errMsg);
+    throwOnSQLiteFailure(db, errMsg);
+    return db;
+  }
+
+  void
+  legacy_export(sqlite3* db)
+  {
+    char* errMsg = nullptr;
+    sqlite3_exec(db,
+                 "DROP TABLE IF EXISTS ParameterSets;"
+                 "CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);",
+                 nullptr,
+                 nullptr,
+                 &errMsg);
+    throwOnSQLiteFailure(db, errMsg);
+    sqlite3_stmt* oStmt = nullptr;
+    sqlite3_prepare_v2(
+      db,
+      "INSERT OR IGNORE INTO ParameterSets(ID, PSetBlob) VALUES(?, ?);",
+      -1,
+      &oStmt,
+      nullptr);
+    throwOnSQLiteFailure(db);
+    for (auto const& [psid, ps] : ParameterSetRegistry::get()) {
+      std::string const id{psid.to_string()};
+      std::string const psBlob{ps.to_compact_string()};
+      sqlite3_bind_text(oStmt, 1, id.c_str(), id.size() + 1, SQLITE_STATIC);
+      sqlite3_bind_text(
+        oStmt, 2, psBlob.c_str(), psBlob.size() + 1, SQLITE_STATIC);
+      if (sqlite3_step(oStmt) != SQLITE_DONE) {
+        throwOnSQLiteFailure(db);
+      }
+      sqlite3_reset(oStmt);
+    }
+    sqlite3_finalize(oStmt);
+  }
+
+  template <typename F>
+  double
+  ns_per_set(std::string const& filename, std::size_t const nsets, F export_to)
+  {
+    sqlite3* db = open_target(filename);
+    auto const ns = bench::ns_per_op(1, [db, &export_to](std::size_t) {
+      export_to(db);
+    });
+    sqlite3_close(db);
+    std::remove(filename.c_str());
+    return ns / nsets;
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const scale = bench::scale(argc, argv);
+  std::size_t const nsets = 10000 * scale;
+
+  for (std::size_t i = 0; i != nsets; ++i) {
+    ParameterSetRegistry::put(ParameterSet::make(
+      "index: " + std::to_string(i) +
+      " module: { type: \"Producer\" threshold: 2.5 labels: [ a, b, c ] }"));
+  }
+  auto const nentries = ParameterSetRegistry::size();
+
+  auto const filename =
+    (std::filesystem::temp_directory_path() / "ParameterSetRegistry_export.db")
+      .string();
+  bench::report("export per set (legacy, row-by-row commit)",
+                ns_per_set(filename, nentries, legacy_export));
+  bench::report("export per set (exportTo)",
+                ns_per_set(filename, nentries, ParameterSetRegistry::exportTo));
+}
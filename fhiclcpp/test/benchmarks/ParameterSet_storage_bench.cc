@@ -0,0 +1,114 @@
+// ======================================================================
+//
+// ParameterSet_storage_bench: get, put and copy on tables of 10, 100
+//                             and 10k keys.
+//
+// The "legacy" variants exercise the node-based std::map that
+// previously held a ParameterSet's values, side by side with the flat
+// map that replaced it; the remaining figures go through ParameterSet
+// itself.  Keys are put in index order ("p0", "p1", ...), which is not
+// their sorted order.
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/detail/FlatMap.h"
+#include "fhiclcpp/test/benchmarks/bench_utils.h"
+
+#include <any>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+
+  std::vector<std::string>
+  make_keys(std::size_t const nkeys)
+  {
+    std::vector<std::string> result;
+    for (std::size_t i = 0; i != nkeys; ++i) {
+      result.push_back("p" + std::to_string(i));
+    }
+    return result;
+  }
+
+  template <typename Map>
+  Map
+  fill(std::vector<std::string> const& keys)
+  {
+    Map result;
+    for (std::size_t i = 0; i != keys.size(); ++i) {
+      result.emplace(keys[i], std::any{std::to_string(i)});
+    }
+    return result;
+  }
+
+  template <typename Map>
+  void
+  run_container(std::string const& label,
+                std::vector<std::string> const& keys,
+                std::size_t const n)
+  {
+    auto const nkeys = std::to_string(keys.size());
+    auto const map = fill<Map>(keys);
+    bench::report(label + " find, " + nkeys + " keys",
+                  bench::ns_per_op(n, [&map, &keys](std::size_t const i) {
+                    bench::keep(map.find(keys[i % keys.size()]));
+                  }));
+    auto const ncopies = n / keys.size() + 1;
+    bench::report(label + " fill, " + nkeys + " keys",
+                  bench::ns_per_op(ncopies, [&keys](std::size_t) {
+                    bench::keep(fill<Map>(keys));
+                  }));
+    bench::report(label + " copy, " + nkeys + " keys",
+                  bench::ns_per_op(ncopies, [&map](std::size_t) {
+                    Map const copy{map};
+                    bench::keep(copy);
+                  }));
+  }
+
+  void
+  run_pset(std::vector<std::string> const& keys, std::size_t const n)
+  {
+    auto const nkeys = std::to_string(keys.size());
+    auto put_all = [&keys] {
+      ParameterSet result;
+      for (std::size_t i = 0; i != keys.size(); ++i) {
+        result.put(keys[i], i);
+      }
+      return result;
+    };
+    auto const pset = put_all();
+    bench::report("ParameterSet::get, " + nkeys + " keys",
+                  bench::ns_per_op(n, [&pset, &keys](std::size_t const i) {
+                    bench::keep(pset.get<std::size_t>(keys[i % keys.size()]));
+                  }));
+    auto const ncopies = n / keys.size() + 1;
+    bench::report("ParameterSet::put (all keys), " + nkeys + " keys",
+                  bench::ns_per_op(ncopies, [&put_all](std::size_t) {
+                    bench::keep(put_all());
+                  }));
+    bench::report("ParameterSet copy, " + nkeys + " keys",
+                  bench::ns_per_op(ncopies, [&pset](std::size_t) {
+                    ParameterSet const copy{pset};
+                    bench::keep(copy);
+                  }));
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const scale = bench::scale(argc, argv);
+  std::size_t const n = 100000 * scale;
+
+  for (std::size_t const nkeys : {10u, 100u, 10000u}) {
+    auto const keys = make_keys(nkeys);
+    run_container<std::map<std::string, std::any>>("legacy std::map", keys, n);
+    run_container<detail::FlatMap<std::string, std::any>>("FlatMap", keys, n);
+    run_pset(keys, n);
+  }
+}
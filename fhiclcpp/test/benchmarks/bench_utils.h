@@ -0,0 +1,64 @@
+#ifndef fhiclcpp_test_benchmarks_bench_utils_h
+#define fhiclcpp_test_benchmarks_bench_utils_h
+
+// ======================================================================
+//
+// bench_utils: minimal timing support for the fhiclcpp microbenchmarks
+//
+// Each benchmark takes an optional scale factor as its first argument
+// so that the default (used when run as a test) stays quick.
+//
+// ======================================================================
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace fhicl::bench {
+
+  // Prevent the compiler from discarding a computed value.
+  template <typename T>
+  inline void
+  keep(T const& t)
+  {
+    asm volatile("" : : "g"(&t) : "memory");
+  }
+
+  inline std::size_t
+  scale(int const argc, char** argv)
+  {
+    return argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1ul;
+  }
+
+  // Mean wall-clock time per call of f(i), i in [0, n), in nanoseconds.
+  template <typename F>
+  double
+  ns_per_op(std::size_t const n, F f)
+  {
+    auto const start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i != n; ++i) {
+      f(i);
+    }
+    std::chrono::duration<double, std::nano> const elapsed =
+      std::chrono::steady_clock::now() - start;
+    return n == 0 ? 0. : elapsed.count() / n;
+  }
+
+  inline void
+  report(std::string const& what, double const ns)
+  {
+    std::cout << std::left << std::setw(48) << what << std::right
+              << std::setw(12) << std::fixed << std::setprecision(1) << ns
+              << " ns/op" << std::setw(14) << std::setprecision(0)
+              << (ns > 0. ? 1e9 / ns : 0.) << " op/s\n";
+  }
+}
+
+#endif /* fhiclcpp_test_benchmarks_bench_utils_h */
+
+// Local Variables:
+// mode: c++
+// End:
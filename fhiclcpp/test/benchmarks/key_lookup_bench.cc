@@ -0,0 +1,91 @@
+// ======================================================================
+//
+// key_lookup_bench: get<int> and has_key with a key given as a string
+//                   and as a precompiled fhicl::Key.
+//
+// The "legacy split" figure is the cost of splitting a key as
+// ParameterSet did before Key existed, on '.' and then with a regular
+// expression per name; it is paid on every lookup by a string key, on
+// top of the lookup itself.
+//
+// ======================================================================
+
+#include "boost/algorithm/string.hpp"
+#include "cetlib/split_by_regex.h"
+#include "fhiclcpp/Key.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/test/benchmarks/bench_utils.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+
+  std::regex const reBrackets{R"((\]\[|\[|\]))"};
+
+  // Split "name[0][5][1]" according to delimiters "][", "[", and "]".
+  std::vector<std::size_t>
+  legacy_sequence_indices(std::string const& name)
+  {
+    auto const tokens = cet::split_by_regex(name, reBrackets);
+    std::vector<std::size_t> indices;
+    for (auto it = tokens.cbegin() + 1, e = tokens.cend(); it != e; ++it) {
+      indices.push_back(std::stoul(*it));
+    }
+    return indices;
+  }
+
+  void
+  legacy_split(std::string const& key)
+  {
+    std::vector<std::string> names;
+    boost::algorithm::split(names, key, boost::algorithm::is_any_of("."));
+    names.erase(std::remove(names.begin(), names.end(), ""), names.end());
+    for (auto const& name : names) {
+      bench::keep(legacy_sequence_indices(name));
+    }
+  }
+
+  void
+  run(ParameterSet const& pset, std::string const& text, std::size_t const n)
+  {
+    Key const key{text};
+    bench::report("legacy split \"" + text + "\"",
+                  bench::ns_per_op(
+                    n, [&text](std::size_t) { legacy_split(text); }));
+    bench::report("get<int>(string) \"" + text + "\"",
+                  bench::ns_per_op(n, [&pset, &text](std::size_t) {
+                    bench::keep(pset.get<int>(text));
+                  }));
+    bench::report("get<int>(Key) \"" + text + "\"",
+                  bench::ns_per_op(n, [&pset, &key](std::size_t) {
+                    bench::keep(pset.get<int>(key));
+                  }));
+    bench::report("has_key(string) \"" + text + "\"",
+                  bench::ns_per_op(n, [&pset, &text](std::size_t) {
+                    bench::keep(pset.has_key(text));
+                  }));
+    bench::report("has_key(Key) \"" + text + "\"",
+                  bench::ns_per_op(n, [&pset, &key](std::size_t) {
+                    bench::keep(pset.has_key(key));
+                  }));
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const scale = bench::scale(argc, argv);
+  auto const pset = ParameterSet::make(
+    "x: 1 a: { b: [ [0, 1], [2, 3], [{ c: 4 }] ] d: { e: { f: 5 } } }");
+  auto const n = 100000 * scale;
+  run(pset, "x", n);
+  run(pset, "a.d.e.f", n);
+  run(pset, "a.b[1][0]", n);
+  run(pset, "a.b[2][0].c", n);
+}
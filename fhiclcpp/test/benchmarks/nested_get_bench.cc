@@ -0,0 +1,87 @@
+// ======================================================================
+//
+// nested_get_bench: get, get_if_present and has_key on the key
+//                   "a.b.c.d", with 10, 1k and 10k sibling keys at
+//                   each level of nesting.
+//
+// The "legacy" variant descends as ParameterSet did before nested
+// tables were looked at in place: each level is copied out of the
+// registry with get<ParameterSet>, so its cost grows with the size of
+// the tables on the way down.  The others should not.
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/test/benchmarks/bench_utils.h"
+
+#include <cstddef>
+#include <string>
+
+using namespace fhicl;
+
+namespace {
+
+  void
+  add_siblings(ParameterSet& pset, std::size_t const nsiblings)
+  {
+    for (std::size_t i = 0; i != nsiblings; ++i) {
+      pset.put("p" + std::to_string(i), i);
+    }
+  }
+
+  ParameterSet
+  make_nested(std::size_t const nsiblings)
+  {
+    ParameterSet c;
+    add_siblings(c, nsiblings);
+    c.put("d", 42);
+    ParameterSet b;
+    add_siblings(b, nsiblings);
+    b.put("c", c);
+    ParameterSet a;
+    add_siblings(a, nsiblings);
+    a.put("b", b);
+    ParameterSet result;
+    add_siblings(result, nsiblings);
+    result.put("a", a);
+    return result;
+  }
+
+  int
+  legacy_get(ParameterSet const& pset)
+  {
+    auto const a = pset.get<ParameterSet>("a");
+    auto const b = a.get<ParameterSet>("b");
+    auto const c = b.get<ParameterSet>("c");
+    return c.get<int>("d");
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const scale = bench::scale(argc, argv);
+
+  for (std::size_t const nsiblings : {10u, 1000u, 10000u}) {
+    auto const pset = make_nested(nsiblings);
+    auto const suffix = ", " + std::to_string(nsiblings) + " siblings";
+    auto const n_legacy = (100000 / nsiblings) * scale;
+    auto const n = 100000 * scale;
+    bench::report("legacy get<int>(\"a.b.c.d\")" + suffix,
+                  bench::ns_per_op(n_legacy, [&pset](std::size_t) {
+                    bench::keep(legacy_get(pset));
+                  }));
+    bench::report("get<int>(\"a.b.c.d\")" + suffix,
+                  bench::ns_per_op(n, [&pset](std::size_t) {
+                    bench::keep(pset.get<int>("a.b.c.d"));
+                  }));
+    bench::report("get_if_present<int>(\"a.b.c.d\")" + suffix,
+                  bench::ns_per_op(n, [&pset](std::size_t) {
+                    bench::keep(pset.get_if_present<int>("a.b.c.d"));
+                  }));
+    bench::report("has_key(\"a.b.c.d\")" + suffix,
+                  bench::ns_per_op(n, [&pset](std::size_t) {
+                    bench::keep(pset.has_key("a.b.c.d"));
+                  }));
+  }
+}
@@ -0,0 +1,126 @@
+// ======================================================================
+//
+// number_text_bench: throughput of encoding integers and
+//                    floating-point values to their canonical text,
+//                    and of reading the values back.
+//
+// The "legacy" variants are the boost::lexical_cast-based conversions
+// that encode and decode used before the stack-buffer ones.
+//
+// ======================================================================
+
+#include "boost/lexical_cast.hpp"
+#include "cetlib/canonical_number.h"
+#include "fhiclcpp/coding.h"
+#include "fhiclcpp/detail/number_text.h"
+#include "fhiclcpp/test/benchmarks/bench_utils.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+using boost::lexical_cast;
+using detail::ldbl;
+
+namespace {
+
+  std::string
+  legacy_encode(std::uintmax_t const value)
+  {
+    std::string result = lexical_cast<std::string>(value);
+    if (result.size() > 6) {
+      std::size_t sz = result.size() - 1;
+      result.insert(1, ".");
+      result += "e+" + lexical_cast<std::string>(sz);
+    }
+    return result;
+  }
+
+  std::string
+  legacy_encode(ldbl const value)
+  {
+    std::string result;
+    cet::canonical_number(lexical_cast<std::string>(value), result);
+    return result;
+  }
+
+  constexpr std::size_t nvalues{1 << 16};
+
+  std::vector<std::uintmax_t>
+  make_integers()
+  {
+    std::mt19937_64 engine{17};
+    std::uniform_int_distribution<int> ndigits{1, 18};
+    std::vector<std::uintmax_t> result;
+    for (std::size_t i = 0; i != nvalues; ++i) {
+      std::uintmax_t const bound = std::pow(10., ndigits(engine));
+      result.push_back(engine() % bound);
+    }
+    return result;
+  }
+
+  std::vector<ldbl>
+  make_floats()
+  {
+    std::mt19937_64 engine{17};
+    std::uniform_real_distribution<double> mantissa{-1., 1.};
+    std::uniform_int_distribution<int> exponent{-40, 40};
+    std::vector<ldbl> result;
+    for (std::size_t i = 0; i != nvalues; ++i) {
+      result.push_back(std::ldexp(mantissa(engine), exponent(engine)));
+    }
+    return result;
+  }
+
+  template <typename T, typename F>
+  void
+  run(std::string const& label,
+      std::vector<T> const& values,
+      std::size_t const n,
+      F f)
+  {
+    bench::report(label, bench::ns_per_op(n, [&values, &f](std::size_t i) {
+                    bench::keep(f(values[i % values.size()]));
+                  }));
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const scale = bench::scale(argc, argv);
+  std::size_t const n = 1000000 * scale;
+
+  auto const integers = make_integers();
+  run("legacy encode(uintmax_t)", integers, n, [](auto v) {
+    return legacy_encode(v);
+  });
+  run("encode(uintmax_t)", integers, n, [](auto v) {
+    return detail::encode(v);
+  });
+
+  auto const floats = make_floats();
+  run("legacy encode(long double)", floats, n, [](auto v) {
+    return legacy_encode(v);
+  });
+  run("encode(long double)", floats, n, [](auto v) {
+    return detail::encode(v);
+  });
+
+  std::vector<std::string> texts;
+  for (auto const v : floats) {
+    texts.push_back(detail::encode(v));
+  }
+  run("legacy lexical_cast<long double>", texts, n, [](auto const& text) {
+    return lexical_cast<ldbl>(text);
+  });
+  run("number_value", texts, n, [](auto const& text) {
+    ldbl value;
+    detail::number_value(text, value);
+    return value;
+  });
+}
@@ -0,0 +1,97 @@
+// ======================================================================
+//
+// sequence_decode_bench: get<std::vector<T>> on numeric sequences of
+//                        1k, 100k and 1M elements.
+//
+// The "legacy" variant is the element-by-element decode that
+// get<std::vector<T>> used before the bulk one: a copy of the stored
+// sequence, then a decode and push_back per element.  It is run on the
+// sequence as a ps_sequence_t of TypedAtoms, the form ParameterSet
+// stored it in before numeric sequences were packed.
+//
+// ======================================================================
+
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/coding.h"
+#include "fhiclcpp/test/benchmarks/bench_utils.h"
+
+#include <any>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+
+  template <typename T>
+  std::vector<T>
+  legacy_decode(std::any const& a)
+  {
+    auto const seq = std::any_cast<detail::ps_sequence_t>(a);
+    std::vector<T> result;
+    T via;
+    for (auto const& e : seq) {
+      detail::decode(e, via);
+      result.push_back(via);
+    }
+    return result;
+  }
+
+  template <typename T>
+  std::any
+  unpacked(std::vector<T> const& values)
+  {
+    detail::ps_sequence_t result;
+    result.reserve(values.size());
+    for (auto const value : values) {
+      result.emplace_back(detail::TypedAtom{detail::encode(value)});
+    }
+    return result;
+  }
+
+  template <typename T>
+  void
+  run(std::string const& type,
+      std::any const& stored,
+      ParameterSet const& pset,
+      std::size_t const nelements,
+      std::size_t const n)
+  {
+    auto const suffix = ", " + std::to_string(nelements) + " elements";
+    bench::report("legacy decode<" + type + ">" + suffix,
+                  bench::ns_per_op(n, [&stored](std::size_t) {
+                    bench::keep(legacy_decode<T>(stored));
+                  }));
+    bench::report("get<std::vector<" + type + ">>" + suffix,
+                  bench::ns_per_op(n, [&pset](std::size_t) {
+                    bench::keep(pset.get<std::vector<T>>("values"));
+                  }));
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const scale = bench::scale(argc, argv);
+
+  for (std::size_t const nelements : {1000u, 100000u, 1000000u}) {
+    std::vector<double> values(nelements);
+    std::vector<int> ints(nelements);
+    for (std::size_t i = 0; i != nelements; ++i) {
+      values[i] = 1e-3 * i + 0.125;
+      ints[i] = static_cast<int>(i);
+    }
+    ParameterSet doubles;
+    doubles.put("values", values);
+    ParameterSet integers;
+    integers.put("values", ints);
+    auto const stored_doubles = unpacked(values);
+    auto const stored_ints = unpacked(ints);
+
+    auto const n = (1000000 / nelements) * scale;
+    run<double>("double", stored_doubles, doubles, nelements, n);
+    run<float>("float", stored_doubles, doubles, nelements, n);
+    run<int>("int", stored_ints, integers, nelements, n);
+  }
+}
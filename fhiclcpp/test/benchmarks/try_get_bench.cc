@@ -0,0 +1,137 @@
+// ======================================================================
+//
+// try_get_bench: finding out what a key names, and whether its value
+//                converts to a type, with and without exceptions.
+//
+// The "legacy" variants ask as library code did before kind_of and
+// try_get: by catching the exception thrown for an absent key or for
+// a value of another type.
+//
+// ======================================================================
+
+#include "fhiclcpp/DatabaseSupport.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/test/benchmarks/bench_utils.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+using namespace fhicl;
+
+namespace {
+
+  // A table of nsequences sequences of numbers, and one sequence of
+  // tables.
+  ParameterSet
+  make_pset(std::size_t const nsequences)
+  {
+    ParameterSet result;
+    for (std::size_t i = 0; i != nsequences; ++i) {
+      result.put("s" + std::to_string(i), std::vector<int>{1, 2, 3});
+    }
+    ParameterSet nested;
+    nested.put("x", 1);
+    result.put("tables", std::vector<ParameterSet>{nested, nested});
+    return result;
+  }
+
+  bool
+  legacy_holds_tables(ParameterSet const& pset, std::string const& key)
+  {
+    try {
+      pset.get<std::vector<ParameterSet>>(key);
+      return true;
+    }
+    catch (fhicl::exception const&) {
+      return false;
+    }
+  }
+
+  bool
+  legacy_is_sequence(ParameterSet const& pset, std::string const& key)
+  {
+    try {
+      return pset.is_key_to_sequence(key);
+    }
+    catch (fhicl::exception const&) {
+      return false;
+    }
+  }
+
+  // decompose_parameterset as it was.
+  void
+  legacy_decompose(ParameterSet const& top,
+                   std::vector<std::string>& records,
+                   std::vector<std::string>& hashes)
+  {
+    records.push_back(top.to_compact_string());
+    hashes.push_back(top.id().to_string());
+    for (auto const& key : top.get_names()) {
+      if (top.is_key_to_table(key))
+        legacy_decompose(top.get<ParameterSet>(key), records, hashes);
+      else if (top.is_key_to_sequence(key)) {
+        try {
+          auto nestlings = top.get<std::vector<ParameterSet>>(key);
+          for (auto const& ps : nestlings)
+            legacy_decompose(ps, records, hashes);
+        }
+        catch (fhicl::exception const&) {
+        }
+      }
+    }
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  auto const scale = bench::scale(argc, argv);
+  auto const pset = make_pset(100);
+  auto const n = 100000 * scale;
+
+  bench::report("legacy get<vector<ParameterSet>> mismatch",
+                bench::ns_per_op(n, [&pset](std::size_t) {
+                  bench::keep(legacy_holds_tables(pset, "s0"));
+                }));
+  bench::report("try_get<vector<ParameterSet>> mismatch",
+                bench::ns_per_op(n, [&pset](std::size_t) {
+                  bench::keep(
+                    pset.try_get<std::vector<ParameterSet>>("s0").has_value());
+                }));
+  bench::report("legacy get<int> mismatch",
+                bench::ns_per_op(n, [&pset](std::size_t) {
+                  try {
+                    bench::keep(pset.get<int>("s0"));
+                  }
+                  catch (fhicl::exception const&) {
+                  }
+                }));
+  bench::report("try_get<int> mismatch",
+                bench::ns_per_op(n, [&pset](std::size_t) {
+                  bench::keep(pset.try_get<int>("s0").has_value());
+                }));
+  bench::report("legacy is_key_to_sequence, absent",
+                bench::ns_per_op(n, [&pset](std::size_t) {
+                  bench::keep(legacy_is_sequence(pset, "absent"));
+                }));
+  bench::report("kind_of, absent", bench::ns_per_op(n, [&pset](std::size_t) {
+                  bench::keep(pset.kind_of("absent"));
+                }));
+
+  auto const n_decompose = 1000 * scale;
+  bench::report("legacy decompose_parameterset",
+                bench::ns_per_op(n_decompose, [&pset](std::size_t) {
+                  std::vector<std::string> records;
+                  std::vector<std::string> hashes;
+                  legacy_decompose(pset, records, hashes);
+                  bench::keep(records.size());
+                }));
+  bench::report("decompose_parameterset",
+                bench::ns_per_op(n_decompose, [&pset](std::size_t) {
+                  std::vector<std::string> records;
+                  std::vector<std::string> hashes;
+                  decompose_parameterset(pset, records, hashes);
+                  bench::keep(records.size());
+                }));
+}
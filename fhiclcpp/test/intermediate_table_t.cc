@@ -4,7 +4,9 @@
 #include "fhiclcpp/ParameterSet.h"
 #include "fhiclcpp/intermediate_table.h"
 
+#include <any>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using namespace fhicl;
@@ -39,6 +41,21 @@ BOOST_AUTO_TEST_CASE(main)
   BOOST_TEST(table.get<table_t const&>("table.t1").size() == 0u);
 }
 
+BOOST_AUTO_TEST_CASE(string_view_keys)
+{
+  intermediate_table table;
+  table.put("table.sequence", std::vector<int>{5, 10});
+  std::string const text{"table.sequence[1] extra"};
+  auto const key = std::string_view{text}.substr(0, 17);
+  BOOST_TEST(table.exists(key));
+  BOOST_TEST(!table.exists(key.substr(0, 7)));
+  BOOST_TEST(std::any_cast<std::string>(table.find(key).value) == "10");
+  auto* item = table.locate(key.substr(0, 14));
+  BOOST_REQUIRE(item != nullptr);
+  BOOST_TEST(item->is_a(SEQUENCE));
+  BOOST_CHECK_THROW(table.find(key.substr(0, 7)), fhicl::exception);
+}
+
 BOOST_AUTO_TEST_CASE(prolog_erase_nested)
 {
   char const* cfg = R"(BEGIN_PROLOG
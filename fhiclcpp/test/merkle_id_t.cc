@@ -0,0 +1,135 @@
+#define BOOST_TEST_MODULE (merkle ID test)
+
+#include "boost/test/unit_test.hpp"
+
+#include "cetlib/sha1.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "fhiclcpp/ParameterSetRegistry.h"
+#include "fhiclcpp/test/boost_test_print_pset.h"
+
+#include "sqlite3.h"
+
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+using namespace fhicl;
+using fhicl::detail::throwOnSQLiteFailure;
+
+namespace {
+  std::string
+  sha1_string(std::string const& text)
+  {
+    cet::sha1 sha{text};
+    std::ostringstream oss;
+    oss << std::hex << std::setfill('0');
+    for (unsigned int const num : sha.digest()) {
+      oss << std::setw(2) << num;
+    }
+    return oss.str();
+  }
+
+  // The scheme must be selected before any ID is computed.
+  struct SelectMerkleScheme {
+    SelectMerkleScheme() { ParameterSetID::set_scheme(id_scheme::merkle); }
+  };
+}
+
+BOOST_GLOBAL_FIXTURE(SelectMerkleScheme);
+
+BOOST_AUTO_TEST_SUITE(merkle_id_t)
+
+BOOST_AUTO_TEST_CASE(scheme_is_fixed)
+{
+  auto const pset = ParameterSet::make("a: 1");
+  BOOST_TEST(pset.id().is_valid());
+  BOOST_TEST((ParameterSetID::scheme() == id_scheme::merkle));
+  BOOST_CHECK_NO_THROW(ParameterSetID::set_scheme(id_scheme::merkle));
+  BOOST_CHECK_THROW(ParameterSetID::set_scheme(id_scheme::canonical_string),
+                    fhicl::exception);
+}
+
+BOOST_AUTO_TEST_CASE(digest_covers_child_ids)
+{
+  auto const pset = ParameterSet::make("a: 1 b: { c: 2 } d: [ { e: 3 } ]");
+  auto const b = pset.get<ParameterSet>("b");
+  auto const d0 = pset.get<ParameterSet>("d[0]");
+  std::string const expected = "@merkle:v1 a:1 b:@id::" + b.id().to_string() +
+                               " d:[@id::" + d0.id().to_string() + "]";
+  BOOST_TEST(pset.id().to_string() == sha1_string(expected));
+  BOOST_TEST(b.id().to_string() == sha1_string("@merkle:v1 c:2"));
+
+  // The canonical string form is unaffected by the scheme.
+  BOOST_TEST(pset.to_string() == "a:1 b:{c:2} d:[{e:3}]");
+  BOOST_TEST(pset.id().to_string() != sha1_string(pset.to_string()));
+}
+
+BOOST_AUTO_TEST_CASE(nested_changes_propagate)
+{
+  auto const p1 = ParameterSet::make("x: { y: { z: 1 } }");
+  auto const p2 = ParameterSet::make("x: { y: { z: 2 } }");
+  auto const p3 = ParameterSet::make("x: { y: { z: 1 } }");
+  BOOST_TEST(p1 != p2);
+  BOOST_TEST(p1 == p3);
+}
+
+BOOST_AUTO_TEST_CASE(legacy_ids_resolvable)
+{
+  // A database written by a job using the canonical_string scheme.
+  std::string const blob{"a:5 b:\"legacy\""};
+  std::string const legacy_id{sha1_string(blob)};
+
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(!sqlite3_open(":memory:", &db));
+  char* errMsg = nullptr;
+  std::string const sql{"CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);"
+                        "INSERT INTO ParameterSets VALUES('" +
+                        legacy_id + "', '" + blob + "');"};
+  sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg);
+  throwOnSQLiteFailure(db, errMsg);
+  ParameterSetRegistry::importFrom(db);
+  BOOST_TEST_REQUIRE(sqlite3_close(db) == SQLITE_OK);
+
+  ParameterSetID const id{legacy_id};
+  auto const& pset = ParameterSetRegistry::get(id);
+  BOOST_TEST(pset.get<int>("a") == 5);
+  BOOST_TEST(pset.get<std::string>("b") == "legacy");
+}
+
+BOOST_AUTO_TEST_CASE(legacy_nested_ids)
+{
+  // A parent and a nested table, as written under the
+  // canonical_string scheme, the parent referring to the nested table
+  // by its legacy ID.
+  std::string const child_blob{"c:2"};
+  std::string const child_id{sha1_string(child_blob)};
+  std::string const parent_blob{"a:1 b:@id::" + child_id};
+  std::string const parent_id{sha1_string("a:1 b:{c:2}")};
+
+  sqlite3* db = nullptr;
+  BOOST_TEST_REQUIRE(!sqlite3_open(":memory:", &db));
+  char* errMsg = nullptr;
+  std::string const sql{"CREATE TABLE ParameterSets(ID PRIMARY KEY, PSetBlob);"
+                        "INSERT INTO ParameterSets VALUES('" +
+                        child_id + "', '" + child_blob +
+                        "');"
+                        "INSERT INTO ParameterSets VALUES('" +
+                        parent_id + "', '" + parent_blob + "');"};
+  sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg);
+  throwOnSQLiteFailure(db, errMsg);
+  ParameterSetRegistry::importFrom(db);
+  BOOST_TEST_REQUIRE(sqlite3_close(db) == SQLITE_OK);
+
+  // The same content has the same ID, whichever way it was made.
+  auto const legacy = ParameterSetRegistry::get(ParameterSetID{parent_id});
+  auto const fresh = ParameterSet::make("a: 1 b: { c: 2 }");
+  BOOST_TEST(legacy.id() == fresh.id());
+  BOOST_TEST(legacy == fresh);
+  BOOST_TEST(legacy.get<ParameterSet>("b").id() ==
+             fresh.get<ParameterSet>("b").id());
+  std::string const expected =
+    "@merkle:v1 a:1 b:@id::" + sha1_string("@merkle:v1 c:2");
+  BOOST_TEST(legacy.id().to_string() == sha1_string(expected));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
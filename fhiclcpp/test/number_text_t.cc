@@ -0,0 +1,233 @@
+// ======================================================================
+//
+// test the number <-> text conversions of encode and decode against
+// the boost::lexical_cast-based implementation they replaced
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (number_text test)
+#include "boost/test/unit_test.hpp"
+
+#include "boost/lexical_cast.hpp"
+#include "cetlib/canonical_number.h"
+#include "fhiclcpp/coding.h"
+#include "fhiclcpp/detail/number_text.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using boost::lexical_cast;
+using fhicl::detail::ldbl;
+using std::string;
+
+namespace {
+
+  string
+  legacy_encode(std::uintmax_t const value)
+  {
+    string result = lexical_cast<string>(value);
+    if (result.size() > 6) {
+      std::size_t sz = result.size() - 1;
+      result.insert(1, ".");
+      result += "e+" + lexical_cast<string>(sz);
+    }
+    return result;
+  }
+
+  string
+  legacy_encode(ldbl const value)
+  {
+    string result;
+    cet::canonical_number(lexical_cast<string>(value), result);
+    return result;
+  }
+
+  string
+  encoded(std::uintmax_t const value)
+  {
+    return fhicl::detail::encode(value);
+  }
+
+  string
+  encoded(std::intmax_t const value)
+  {
+    return fhicl::detail::encode(value);
+  }
+
+  string
+  encoded_float(ldbl const value)
+  {
+    return fhicl::detail::float_text(value);
+  }
+
+  std::vector<ldbl>
+  floating_values()
+  {
+    std::vector<ldbl> result{0.1L,
+                             -0.1L,
+                             0.5L,
+                             1.5L,
+                             -2.25L,
+                             3.14159265358979323846L,
+                             1e-5L,
+                             1.5e-300L,
+                             1e30L,
+                             -1e30L,
+                             1.0e19L,
+                             123456.5L,
+                             1234567.5L,
+                             std::numeric_limits<ldbl>::min(),
+                             std::numeric_limits<ldbl>::denorm_min(),
+                             std::numeric_limits<ldbl>::max(),
+                             std::numeric_limits<ldbl>::lowest(),
+                             std::numeric_limits<ldbl>::epsilon(),
+                             std::numeric_limits<double>::max(),
+                             std::numeric_limits<double>::min(),
+                             std::numeric_limits<float>::max(),
+                             0.1f,
+                             0.1};
+    std::mt19937_64 engine{4711};
+    std::uniform_real_distribution<double> mantissa{-1., 1.};
+    std::uniform_int_distribution<int> exponent{-60, 60};
+    for (int i = 0; i != 20000; ++i) {
+      auto const x = std::ldexp(static_cast<ldbl>(mantissa(engine)) / 3,
+                                exponent(engine));
+      result.push_back(x);
+      result.push_back(static_cast<double>(x));
+      result.push_back(static_cast<float>(x));
+    }
+    return result;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(number_text_test)
+
+BOOST_AUTO_TEST_CASE(integers)
+{
+  std::vector<std::uintmax_t> values{0u, 1u, 9u, 10u, 999999u, 1000000u,
+                                     1234567u, 100000000u};
+  for (std::uintmax_t v = 1; v < std::numeric_limits<std::uintmax_t>::max() / 10;
+       v *= 10) {
+    values.push_back(v - 1);
+    values.push_back(v);
+    values.push_back(v + 1);
+  }
+  values.push_back(std::numeric_limits<std::uintmax_t>::max());
+
+  for (auto const v : values) {
+    BOOST_TEST(encoded(v) == legacy_encode(v));
+    if (v <= static_cast<std::uintmax_t>(std::numeric_limits<std::intmax_t>::max())) {
+      auto const i = static_cast<std::intmax_t>(v);
+      BOOST_TEST(encoded(i) == legacy_encode(v));
+      BOOST_TEST(encoded(-i) == (i == 0 ? "0" : '-' + legacy_encode(v)));
+    }
+  }
+  BOOST_TEST(encoded(std::numeric_limits<std::intmax_t>::min()) ==
+             "-9.223372036854775808e+18");
+}
+
+BOOST_AUTO_TEST_CASE(floating_point)
+{
+  for (auto const v : floating_values()) {
+    BOOST_TEST_CONTEXT("value " << lexical_cast<string>(v))
+    {
+      BOOST_TEST(encoded_float(v) == legacy_encode(v));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(values_of_text)
+{
+  for (auto const v : floating_values()) {
+    auto const text = legacy_encode(v);
+    ldbl value{};
+    BOOST_TEST_REQUIRE(fhicl::detail::number_value(text, value));
+    BOOST_TEST(value == lexical_cast<ldbl>(text));
+  }
+  for (string const text : {"0", "-0", "1", "1.234567e+6", "1e4932", "1e-4940",
+                            "+infinity", "-infinity"}) {
+    BOOST_TEST_CONTEXT("text '" << text << "'")
+    {
+      ldbl value{};
+      BOOST_TEST(fhicl::detail::number_value(text, value));
+      BOOST_TEST(value == lexical_cast<ldbl>(text));
+    }
+  }
+  for (string const text : {"", "1e", ".", "--1", "+-1", "1x", "0x10", "nan",
+                            "1e5000", "infinity1"}) {
+    BOOST_TEST_CONTEXT("text '" << text << "'")
+    {
+      ldbl value{};
+      BOOST_TEST(!fhicl::detail::number_value(text, value));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(double_values_of_text)
+{
+  for (auto const v : floating_values()) {
+    auto const text = legacy_encode(v);
+    double value{};
+    BOOST_TEST_REQUIRE(fhicl::detail::number_value(text, value));
+    BOOST_TEST(value == lexical_cast<double>(text));
+  }
+  for (string const text : {"1e309", "-1e309"}) {
+    double value{};
+    BOOST_TEST(!fhicl::detail::number_value(text, value));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(integers_of_text)
+{
+  using fhicl::detail::integer_parts;
+  auto const parts_of = [](string const& text) {
+    integer_parts parts;
+    BOOST_TEST_REQUIRE(fhicl::detail::integer_value(text, parts));
+    return parts;
+  };
+  constexpr auto umax = std::numeric_limits<std::uintmax_t>::max();
+
+  for (std::uintmax_t v = 1; v < umax / 10; v *= 10) {
+    for (auto const u : {v - 1, v, v + 1}) {
+      auto const parts = parts_of(legacy_encode(u));
+      BOOST_TEST(parts.integral);
+      BOOST_TEST(parts.fits);
+      BOOST_TEST(parts.magnitude == u);
+    }
+  }
+  BOOST_TEST(parts_of(legacy_encode(umax)).magnitude == umax);
+  BOOST_TEST(parts_of("-9.223372036854775808e+18").magnitude ==
+             std::uintmax_t{1} << 63);
+  BOOST_TEST(parts_of("-9.223372036854775808e+18").negative);
+  BOOST_TEST(parts_of("120e-1").magnitude == 12u);
+  BOOST_TEST(parts_of("0e99999999999999999999").fits);
+
+  for (string const text : {"18446744073709551616", "1e20", "1e99999"}) {
+    BOOST_TEST_CONTEXT("text '" << text << "'")
+    {
+      auto const parts = parts_of(text);
+      BOOST_TEST(parts.integral);
+      BOOST_TEST(!parts.fits);
+    }
+  }
+  for (string const text :
+       {"0.5", "-1.5", "12e-1", "1.0000000000000000000001", "1e-99999"}) {
+    BOOST_TEST_CONTEXT("text '" << text << "'")
+    {
+      BOOST_TEST(!parts_of(text).integral);
+    }
+  }
+  for (string const text : {"", "1e", ".", "--1", "1x", "infinity"}) {
+    BOOST_TEST_CONTEXT("text '" << text << "'")
+    {
+      integer_parts parts;
+      BOOST_TEST(!fhicl::detail::integer_value(text, parts));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
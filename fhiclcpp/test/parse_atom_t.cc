@@ -0,0 +1,289 @@
+// ======================================================================
+//
+// test parse_atom(), the fast path of parse_value_string(), against
+// the grammar it stands in for
+//
+// ======================================================================
+
+#define BOOST_TEST_MODULE (parse_atom test)
+#include "boost/test/unit_test.hpp"
+
+#include "fhiclcpp/detail/parse_atom.h"
+#include "fhiclcpp/exception.h"
+#include "fhiclcpp/extended_value.h"
+#include "fhiclcpp/parse.h"
+
+#include <string>
+#include <vector>
+
+using fhicl::extended_value;
+using fhicl::detail::parse_atom;
+using fhicl::detail::parse_value_string_grammar;
+using std::string;
+
+namespace {
+
+  // Outcome of a parse, in a form that can be compared and printed.
+  template <typename Parse>
+  string
+  outcome(string const& input, Parse parse)
+  {
+    extended_value result;
+    string unparsed;
+    try {
+      if (!parse(input, result, unparsed)) {
+        return "failed, unparsed '" + unparsed + "'";
+      }
+    }
+    catch (fhicl::exception const&) {
+      return "fhicl::exception";
+    }
+    catch (std::exception const&) {
+      return "std::exception";
+    }
+    return std::to_string(result.tag) + ": '" + result.to_string() +
+           "', unparsed '" + unparsed + "'";
+  }
+
+  string
+  by_grammar(string const& input)
+  {
+    return outcome(input, parse_value_string_grammar);
+  }
+
+  string
+  by_parse_value_string(string const& input)
+  {
+    return outcome(input, fhicl::parse_value_string);
+  }
+
+  bool
+  accepted(string const& input)
+  {
+    extended_value result;
+    return parse_atom(input, result);
+  }
+
+  std::vector<string> const corpus{
+    // nil and booleans
+    "@nil",
+    "@nil_",
+    "@nil,",
+    "@nilx",
+    "true",
+    "false",
+    "True",
+    "truex",
+    "true_",
+    "true,",
+    "true]",
+    // integers
+    "0",
+    "00",
+    "007",
+    "12345678",
+    "123456789012345678901234567890",
+    "1_000",
+    "1a",
+    // decimal numbers
+    "1.",
+    ".5",
+    "-.5",
+    "+5",
+    "-5",
+    "1e5",
+    "1E+5",
+    "1.5e-3",
+    "-0",
+    "1e",
+    "e5",
+    "E",
+    "e",
+    "1..2",
+    "--1",
+    "+-1",
+    "1e5e5",
+    "5,",
+    "5)",
+    "5]",
+    // infinities
+    "infinity",
+    "+infinity",
+    "-infinity",
+    "+ infinity",
+    "infinityx",
+    "infinity_",
+    "Infinity",
+    "infinity)",
+    // hexadecimal and binary
+    "0x1F",
+    "0X1f",
+    "0x",
+    "0xg",
+    "0x1g",
+    "0b101",
+    "0B11",
+    "0b",
+    "0b2",
+    "0b102",
+    "0xdeadbeef",
+    // complex numbers
+    "(1,2)",
+    "( 1 , 2 )",
+    "(1.5e3,-2)",
+    "(-infinity,infinity)",
+    "(0x1F,0b1)",
+    "(1,2",
+    "(1,2,3)",
+    "(1 2)",
+    "(,2)",
+    "(1,)",
+    "()",
+    "(a,b)",
+    "((1,2),3)",
+    "(1,2)x",
+    "(1,2) x",
+    "(1,2)]",
+    "(1e,2)",
+    "(1, 2 3)",
+    // unquoted strings
+    "a",
+    "_",
+    "_a1",
+    "nil_",
+    "abc",
+    "a.b",
+    "a[0]",
+    "a:b",
+    "1abc",
+    "9_",
+    "abc,",
+    "abc def",
+    "a-b",
+    // quoted strings
+    "''",
+    "'a'",
+    "'a b'",
+    "'a\"b'",
+    "'a''",
+    "'a'b",
+    "'a\\'",
+    "'#x'",
+    "'//x'",
+    "\"\"",
+    "\"a\"",
+    "\"a b\"",
+    "\"a\\\"b\"",
+    "\"a\\\\\"",
+    "\"a\\\\\\\"\"",
+    "\"a\\n\"",
+    "\"a'b\"",
+    "\"a\"b",
+    "\"a\" \"b\"",
+    "\"a",
+    "\"",
+    "\"#x\"",
+    "\"/data/file.root\"",
+    "\"a\",",
+    // whitespace and comments
+    "",
+    " ",
+    "\t1\n",
+    " 1 ",
+    "1 # comment",
+    "1 // comment",
+    "1 // comment\n",
+    "# comment\n1",
+    "// comment\n1",
+    "1/2",
+    "1#",
+    // compound values
+    "[]",
+    "[1,2]",
+    "[ 1 , \"a\" ]",
+    "{}",
+    "{a:1}",
+    "{ a: [ 1, (2,3) ] b: @nil }",
+    "@id::0123456789abcdef0123456789abcdef",
+    "@local::a",
+    "1 2",
+  };
+
+  void
+  check_against_grammar(string const& input)
+  {
+    BOOST_TEST_CONTEXT("input '" << input << "'")
+    {
+      BOOST_TEST(by_parse_value_string(input) == by_grammar(input));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(parse_atom_test)
+
+BOOST_AUTO_TEST_CASE(corpus_matches_grammar)
+{
+  for (auto const& input : corpus) {
+    check_against_grammar(input);
+    check_against_grammar(" " + input);
+    check_against_grammar(input + "\n");
+  }
+}
+
+// Every string of up to three characters drawn from those that
+// matter to the token parsers.
+BOOST_AUTO_TEST_CASE(short_strings_match_grammar)
+{
+  string const alphabet{"01x9be.+-_a'\"(),[ \\#/@"};
+  std::vector<string> inputs{""};
+  for (int length = 0; length != 3; ++length) {
+    std::vector<string> longer;
+    for (auto const& prefix : inputs) {
+      for (char const ch : alphabet) {
+        longer.push_back(prefix + ch);
+      }
+    }
+    for (auto const& input : longer) {
+      check_against_grammar(input);
+    }
+    inputs = std::move(longer);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(atoms_take_fast_path)
+{
+  for (string const input : {"@nil",
+                             "true",
+                             "false",
+                             " 42 ",
+                             "007",
+                             "-1.5e3",
+                             "-infinity",
+                             "0x1F",
+                             "0b101",
+                             "(1, -2)",
+                             "abc",
+                             "1abc",
+                             "'a # b'",
+                             "\"a\\\"b\"",
+                             "\"/data/file.root\""}) {
+    BOOST_TEST_CONTEXT("input '" << input << "'")
+    {
+      BOOST_TEST(accepted(input));
+    }
+  }
+  for (string const input : {"[1]",
+                             "{a:1}",
+                             "@id::0123456789abcdef0123456789abcdef",
+                             "1 # comment",
+                             "1 2",
+                             "(1,2",
+                             "\"a"}) {
+    BOOST_TEST_CONTEXT("input '" << input << "'")
+    {
+      BOOST_TEST(!accepted(input));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
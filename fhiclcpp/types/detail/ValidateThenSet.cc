@@ -44,7 +44,8 @@ fhicl::detail::ValidateThenSet::before_action(ParameterBase& p)
   // Check that key exists; allow defaulted or optional keys to be
   // absent.
   std::string const& k = strip_first_containing_name(p.key());
-  if (!pset_.has_key(k) and !cet::search_all(ignorableKeys_, k)) {
+  if (pset_.kind_of(k) == value_kind::absent and
+      !cet::search_all(ignorableKeys_, k)) {
     if (!p.has_default() and !p.is_optional()) {
       missingParameters_.emplace_back(&p);
     }
@@ -83,7 +84,7 @@ fhicl::detail::ValidateThenSet::enter_sequence(SequenceBase& s)
 {
   // Ensure that the supplied parameter represents a sequence.
   auto const& key = strip_first_containing_name(s.key());
-  if (!pset_.is_key_to_sequence(key)) {
+  if (pset_.kind_of(key) != value_kind::sequence) {
     throw fhicl::exception(type_mismatch, "error converting to sequence:\n")
       << "The supplied value of the parameter:\n"
       << "    " << s.key() << '\n'
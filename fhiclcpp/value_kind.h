@@ -0,0 +1,13 @@
+#ifndef fhiclcpp_value_kind_h
+#define fhiclcpp_value_kind_h
+
+namespace fhicl {
+  // What a ParameterSet key names (see ParameterSet::kind_of).
+  enum class value_kind : unsigned char { absent, nil, atom, sequence, table };
+}
+
+#endif /* fhiclcpp_value_kind_h */
+
+// Local Variables:
+// mode: c++
+// End: